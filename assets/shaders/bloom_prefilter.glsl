@@ -0,0 +1,26 @@
+#version 330 core
+
+uniform sampler2D texture0;
+uniform vec2 texelSize;
+
+in vec2 fragTexCoord;
+
+out vec4 FragColor;
+
+// Same cut as threshold.glsl, applied per source texel before averaging
+vec3 Threshold(vec2 coord) {
+    vec3 color = texture(texture0, coord).rgb;
+    float brightness = dot(color, vec3(0.2126, 0.7152, 0.0722));
+    return brightness > 0.3 ? color : vec3(0);
+}
+
+void main() {
+    // Each half resolution pixel covers a 2x2 block of source texels
+    vec2 offset = texelSize * 0.5;
+    vec3 result = Threshold(fragTexCoord + vec2(-offset.x, -offset.y));
+    result += Threshold(fragTexCoord + vec2(offset.x, -offset.y));
+    result += Threshold(fragTexCoord + vec2(-offset.x, offset.y));
+    result += Threshold(fragTexCoord + vec2(offset.x, offset.y));
+
+    FragColor = vec4(result * 0.25, 1.0);
+}
@@ -0,0 +1,25 @@
+#version 330 core
+
+uniform sampler2D texture0;
+uniform vec2 texelSize;
+uniform float radius;
+
+in vec2 fragTexCoord;
+
+out vec4 FragColor;
+
+void main() {
+    // 3x3 tent, weights 1 2 1 in each direction
+    vec2 offset = texelSize * radius;
+    vec3 result = texture(texture0, fragTexCoord).rgb * 4.0;
+    result += texture(texture0, fragTexCoord + vec2(-offset.x, 0)).rgb * 2.0;
+    result += texture(texture0, fragTexCoord + vec2(offset.x, 0)).rgb * 2.0;
+    result += texture(texture0, fragTexCoord + vec2(0, -offset.y)).rgb * 2.0;
+    result += texture(texture0, fragTexCoord + vec2(0, offset.y)).rgb * 2.0;
+    result += texture(texture0, fragTexCoord + vec2(-offset.x, -offset.y)).rgb;
+    result += texture(texture0, fragTexCoord + vec2(offset.x, -offset.y)).rgb;
+    result += texture(texture0, fragTexCoord + vec2(-offset.x, offset.y)).rgb;
+    result += texture(texture0, fragTexCoord + vec2(offset.x, offset.y)).rgb;
+
+    FragColor = vec4(result / 16.0, 1.0);
+}
@@ -0,0 +1,27 @@
+#version 330 core
+
+#define MAX_TAPS 9
+
+uniform sampler2D texture0;
+uniform vec2 direction;
+// Tap 0 is the center; every other tap sits between two kernel texels and
+// lets bilinear filtering blend them, so it is read once on each side
+uniform int tapCount;
+uniform float offsets[MAX_TAPS];
+uniform float weights[MAX_TAPS];
+
+in vec2 fragTexCoord;
+
+out vec4 FragColor;
+
+void main() {
+    vec3 result = texture(texture0, fragTexCoord).rgb * weights[0];
+
+    for (int i = 1; i < tapCount; i++) {
+        vec2 offset = direction * offsets[i];
+        result += texture(texture0, fragTexCoord + offset).rgb * weights[i];
+        result += texture(texture0, fragTexCoord - offset).rgb * weights[i];
+    }
+
+    FragColor = vec4(result, 1.0);
+}
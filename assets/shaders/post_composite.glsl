@@ -0,0 +1,30 @@
+#version 330 core
+
+// scanline.glsl run straight on the scene plus bloom, so the composite never
+// goes through a render texture of its own
+uniform sampler2D texture0;
+uniform sampler2D bloom;
+uniform float time;
+
+in vec2 fragTexCoord;
+
+out vec4 FragColor;
+
+vec3 Composite(vec2 coord) {
+    return min(texture(texture0, coord).rgb + texture(bloom, coord).rgb, 1.0);
+}
+
+void main() {
+    float distortion = sin(fragTexCoord.y * 2304978 * fract(time)) * 0.0007;
+    vec2 distortedCoord = vec2(fragTexCoord.x + distortion, fragTexCoord.y);
+    float scanline = cos((fract((fragTexCoord.y + time * 0.05) * 150 + 0.5) - 0.5) * 3.14);
+
+    vec4 color = vec4(1.0);
+    vec2 offset = vec2(distortion * 3, 0);
+    color.r = Composite(distortedCoord - offset).r;
+    color.g = Composite(distortedCoord).g;
+    color.b = Composite(distortedCoord + offset).b;
+
+    float flicker = 0.95 + 0.05 * sin(time * 10); // 0.9 - 1.0
+    FragColor = vec4(mix(color.rgb, vec3(scanline), 0.1) * flicker, 1.0);
+}
@@ -0,0 +1,54 @@
+#version 330 core
+
+// One texel per tile: the TileState in texture0 (as 8-bit normalized) and
+// the animation timer in timers
+uniform sampler2D texture0;
+uniform sampler2D timers;
+uniform vec2 gridSize;  // columns, rows
+uniform vec2 food;      // column, row; -1 when there is no food
+uniform float tileSize;
+uniform float tileSpacing;
+
+in vec2 fragTexCoord;
+in vec4 fragColor;
+
+out vec4 FragColor;
+
+const float PI = 3.14159265;
+
+// Same palette as GetTileColor, indexed by TileState
+const vec3 palette[6] = vec3[](
+    vec3(20, 20, 20) / 255.0,
+    vec3(50, 50, 50) / 255.0,
+    vec3(255, 255, 255) / 255.0,
+    vec3(40, 255, 40) / 255.0,
+    vec3(255, 40, 40) / 255.0,
+    vec3(200, 20, 160) / 255.0
+);
+
+void main() {
+    vec2 gridCoord = fragTexCoord * gridSize;
+    vec2 cell = floor(gridCoord);
+    int state = int(texelFetch(texture0, ivec2(cell), 0).r * 255.0 + 0.5);
+    float timer = texelFetch(timers, ivec2(cell), 0).r;
+
+    // Pixel offset from the tile center, rotated back into the square's frame
+    vec2 local = (fract(gridCoord) - 0.5) * (tileSize + tileSpacing);
+    float halfSize = tileSize / 2.0;
+    if (state == 0) {
+        float angle = sin(mod(timer, 2.0 * PI)) * PI;
+        float c = cos(angle);
+        float s = sin(angle);
+        local = vec2(c * local.x + s * local.y, c * local.y - s * local.x);
+        halfSize = tileSize / 4.0;
+    }
+    if (any(greaterThan(abs(local), vec2(halfSize)))) {
+        discard;
+    }
+
+    vec3 color = palette[state];
+    if (cell.x == food.x || cell.y == food.y) {
+        color = min(color + 10.0 / 255.0, 1.0);
+    }
+    FragColor = vec4(color, fragColor.a);
+}
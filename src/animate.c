@@ -0,0 +1,139 @@
+#include <math.h>
+#include <stdint.h>
+
+#include "animate.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#define INV_PI 0.318309886f
+
+// Timers wrap at this, so they stay small enough for dt to keep moving
+// them however long the game runs. Only the phase matters to sin.
+#define TWO_PI 6.28318531f
+
+// PI split in three so that k * PI_A and k * PI_B are exact for timers up
+// to about 2^19, which keeps the reduced argument accurate
+#define PI_A 3.125f
+#define PI_B 0.0166015625f
+#define PI_C -8.90891021e-6f
+
+// Odd minimax polynomial for sin on [-PI/2, PI/2], error around 1e-7
+#define SIN_C3 -0.166666571f
+#define SIN_C5 0.00833301729f
+#define SIN_C7 -0.000198066149f
+#define SIN_C9 2.60005416e-6f
+
+// sin(x) = (-1)^k sin(x - k PI), with k the nearest integer to x / PI
+float FastSin(float x) {
+    float k = rintf(x * INV_PI);
+    float r = ((x - k * PI_A) - k * PI_B) - k * PI_C;
+    float r2 = r * r;
+    float p = SIN_C9;
+    p = p * r2 + SIN_C7;
+    p = p * r2 + SIN_C5;
+    p = p * r2 + SIN_C3;
+    float s = r + r * r2 * p;
+    return ((int32_t)k & 1) ? -s : s;
+}
+
+// With dt reduced below TWO_PI first, one subtraction brings a timer back
+// under TWO_PI
+float WrapTimer(float timer) {
+    return timer >= TWO_PI ? timer - TWO_PI : timer;
+}
+
+void AdvanceTileTimers(float *timers, size_t count, float dt) {
+    dt = fmodf(dt, TWO_PI);
+    for (size_t i = 0; i < count; i++) {
+        timers[i] = WrapTimer(timers[i] + dt);
+    }
+}
+
+void AnimateTilesScalar(float *restrict timers, float *restrict angles, size_t count, float dt) {
+    dt = fmodf(dt, TWO_PI);
+    for (size_t i = 0; i < count; i++) {
+        timers[i] = WrapTimer(timers[i] + dt);
+        angles[i] = FastSin(timers[i]) * (float)M_PI;
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+__attribute__((target("sse2")))
+void AnimateTilesSse2(float *restrict timers, float *restrict angles, size_t count, float dt) {
+    dt = fmodf(dt, TWO_PI);
+    __m128 step = _mm_set1_ps(dt);
+    __m128 two_pi = _mm_set1_ps(TWO_PI);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 x = _mm_add_ps(_mm_loadu_ps(timers + i), step);
+        x = _mm_sub_ps(x, _mm_and_ps(_mm_cmpge_ps(x, two_pi), two_pi));
+        _mm_storeu_ps(timers + i, x);
+
+        __m128i ki = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(INV_PI)));
+        __m128 k = _mm_cvtepi32_ps(ki);
+        __m128 r = _mm_sub_ps(x, _mm_mul_ps(k, _mm_set1_ps(PI_A)));
+        r = _mm_sub_ps(r, _mm_mul_ps(k, _mm_set1_ps(PI_B)));
+        r = _mm_sub_ps(r, _mm_mul_ps(k, _mm_set1_ps(PI_C)));
+
+        __m128 r2 = _mm_mul_ps(r, r);
+        __m128 p = _mm_set1_ps(SIN_C9);
+        p = _mm_add_ps(_mm_mul_ps(p, r2), _mm_set1_ps(SIN_C7));
+        p = _mm_add_ps(_mm_mul_ps(p, r2), _mm_set1_ps(SIN_C5));
+        p = _mm_add_ps(_mm_mul_ps(p, r2), _mm_set1_ps(SIN_C3));
+        __m128 s = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(r, r2), p));
+
+        // Odd k flips the sign bit
+        s = _mm_xor_ps(s, _mm_castsi128_ps(_mm_slli_epi32(ki, 31)));
+        _mm_storeu_ps(angles + i, _mm_mul_ps(s, _mm_set1_ps((float)M_PI)));
+    }
+    AnimateTilesScalar(timers + i, angles + i, count - i, dt);
+}
+
+__attribute__((target("avx2")))
+void AnimateTilesAvx2(float *restrict timers, float *restrict angles, size_t count, float dt) {
+    dt = fmodf(dt, TWO_PI);
+    __m256 step = _mm256_set1_ps(dt);
+    __m256 two_pi = _mm256_set1_ps(TWO_PI);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 x = _mm256_add_ps(_mm256_loadu_ps(timers + i), step);
+        x = _mm256_sub_ps(x, _mm256_and_ps(_mm256_cmp_ps(x, two_pi, _CMP_GE_OQ), two_pi));
+        _mm256_storeu_ps(timers + i, x);
+
+        __m256i ki = _mm256_cvtps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(INV_PI)));
+        __m256 k = _mm256_cvtepi32_ps(ki);
+        __m256 r = _mm256_sub_ps(x, _mm256_mul_ps(k, _mm256_set1_ps(PI_A)));
+        r = _mm256_sub_ps(r, _mm256_mul_ps(k, _mm256_set1_ps(PI_B)));
+        r = _mm256_sub_ps(r, _mm256_mul_ps(k, _mm256_set1_ps(PI_C)));
+
+        __m256 r2 = _mm256_mul_ps(r, r);
+        __m256 p = _mm256_set1_ps(SIN_C9);
+        p = _mm256_add_ps(_mm256_mul_ps(p, r2), _mm256_set1_ps(SIN_C7));
+        p = _mm256_add_ps(_mm256_mul_ps(p, r2), _mm256_set1_ps(SIN_C5));
+        p = _mm256_add_ps(_mm256_mul_ps(p, r2), _mm256_set1_ps(SIN_C3));
+        __m256 s = _mm256_add_ps(r, _mm256_mul_ps(_mm256_mul_ps(r, r2), p));
+
+        s = _mm256_xor_ps(s, _mm256_castsi256_ps(_mm256_slli_epi32(ki, 31)));
+        _mm256_storeu_ps(angles + i, _mm256_mul_ps(s, _mm256_set1_ps((float)M_PI)));
+    }
+    AnimateTilesSse2(timers + i, angles + i, count - i, dt);
+}
+
+#endif
+
+void AnimateTiles(float *restrict timers, float *restrict angles, size_t count, float dt) {
+#if defined(__x86_64__) || defined(__i386__)
+    if (__builtin_cpu_supports("avx2")) {
+        AnimateTilesAvx2(timers, angles, count, dt);
+    } else if (__builtin_cpu_supports("sse2")) {
+        AnimateTilesSse2(timers, angles, count, dt);
+    } else {
+        AnimateTilesScalar(timers, angles, count, dt);
+    }
+#else
+    AnimateTilesScalar(timers, angles, count, dt);
+#endif
+}
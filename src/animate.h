@@ -0,0 +1,21 @@
+#ifndef ANIMATE_H
+#define ANIMATE_H
+
+#include <stddef.h>
+
+// Tile animation: every tile's timer advances by dt each frame, wrapping at
+// 2 PI, and its rotation is sin(timer) * PI. The kernels run over the flat timer and
+// angle arrays of a TileGrid, eight lanes at a time on AVX2, four on SSE2,
+// and all of them produce the same values as FastSin.
+float FastSin(float x);
+float WrapTimer(float timer);
+void AdvanceTileTimers(float *timers, size_t count, float dt);
+void AnimateTiles(float *restrict timers, float *restrict angles, size_t count, float dt);
+void AnimateTilesScalar(float *restrict timers, float *restrict angles, size_t count, float dt);
+
+#if defined(__x86_64__) || defined(__i386__)
+void AnimateTilesSse2(float *restrict timers, float *restrict angles, size_t count, float dt);
+void AnimateTilesAvx2(float *restrict timers, float *restrict angles, size_t count, float dt);
+#endif
+
+#endif
@@ -0,0 +1,128 @@
+#include <stdlib.h>
+
+#include "batch.h"
+#include "kernels.h"
+
+void InitGameBatch(GameBatch *batch, size_t count, size_t rows, size_t columns, uint64_t seed) {
+    batch->count = count;
+    batch->rows = rows;
+    batch->columns = columns;
+    batch->kernels = SelectBoardKernels(rows, columns);
+    batch->games = calloc(count, sizeof(Game));
+    batch->head_rows = malloc(sizeof(int) * count);
+    batch->head_columns = malloc(sizeof(int) * count);
+    batch->dirs = malloc(sizeof(Direction) * count);
+    batch->next_dirs = malloc(sizeof(Direction) * count);
+    batch->next_next_dirs = malloc(sizeof(Direction) * count);
+    batch->has_next_next_dirs = malloc(sizeof(bool) * count);
+    batch->food_rows = malloc(sizeof(int) * count);
+    batch->food_columns = malloc(sizeof(int) * count);
+    batch->game_over = malloc(sizeof(bool) * count);
+    batch->eaten = malloc(sizeof(bool) * count);
+
+    for (size_t i = 0; i < count; i++) {
+        InitGame(&batch->games[i], rows, columns, seed + i);
+        GameBatchLoad(batch, i);
+    }
+}
+
+void FreeGameBatch(GameBatch *batch) {
+    for (size_t i = 0; i < batch->count; i++) {
+        FreeGame(&batch->games[i]);
+    }
+    free(batch->games);
+    free(batch->head_rows);
+    free(batch->head_columns);
+    free(batch->dirs);
+    free(batch->next_dirs);
+    free(batch->next_next_dirs);
+    free(batch->has_next_next_dirs);
+    free(batch->food_rows);
+    free(batch->food_columns);
+    free(batch->game_over);
+    free(batch->eaten);
+    batch->count = 0;
+}
+
+// Copies the hot state of game i into the batch arrays
+void GameBatchLoad(GameBatch *batch, size_t i) {
+    Game *game = &batch->games[i];
+    Position *head = SnakeTile(&game->player, 0);
+    batch->head_rows[i] = head->row;
+    batch->head_columns[i] = head->column;
+    batch->dirs[i] = game->player.dir;
+    batch->next_dirs[i] = game->player.next_dir;
+    batch->next_next_dirs[i] = game->player.next_next_dir;
+    batch->has_next_next_dirs[i] = game->player.has_next_next_dir;
+    batch->food_rows[i] = game->food.position.row;
+    batch->food_columns[i] = game->food.position.column;
+    batch->game_over[i] = game->game_over;
+}
+
+// Copies the batch arrays back into game i so it can be used on its own
+void GameBatchStore(GameBatch *batch, size_t i) {
+    Game *game = &batch->games[i];
+    game->player.dir = batch->dirs[i];
+    game->player.next_dir = batch->next_dirs[i];
+    game->player.next_next_dir = batch->next_next_dirs[i];
+    game->player.has_next_next_dir = batch->has_next_next_dirs[i];
+    game->food.position.row = batch->food_rows[i];
+    game->food.position.column = batch->food_columns[i];
+    game->game_over = batch->game_over[i];
+}
+
+void GameBatchRestart(GameBatch *batch, size_t i) {
+    RestartGame(&batch->games[i]);
+    GameBatchLoad(batch, i);
+}
+
+void GameBatchHandleInput(GameBatch *batch, const unsigned *inputs) {
+    for (size_t i = 0; i < batch->count; i++) {
+        HandleDirectionInput(batch->dirs[i], &batch->next_dirs[i], &batch->next_next_dirs[i], &batch->has_next_next_dirs[i], inputs[i]);
+    }
+}
+
+void GameBatchAdvanceHeads(GameBatch *batch) {
+    batch->kernels->advance_heads(batch);
+}
+
+void GameBatchStep(GameBatch *batch, unsigned *events) {
+    for (size_t i = 0; i < batch->count; i++) {
+        MoveClones(&batch->games[i]);
+    }
+
+    GameBatchAdvanceHeads(batch);
+
+    for (size_t i = 0; i < batch->count; i++) {
+        Game *game = &batch->games[i];
+        unsigned game_events = 0;
+
+        if (!batch->game_over[i]) {
+            Position head = (Position) {
+                .row = batch->head_rows[i],
+                .column = batch->head_columns[i]
+            };
+            SnakeAdvance(game, &game->player, head);
+            PlayerPathPush(&game->player_path, batch->dirs[i]);
+
+            if (batch->eaten[i]) {
+                game_events |= STEP_FOOD_EATEN;
+                if (!GameEatFood(game)) {
+                    game_events |= STEP_BOARD_FULL;
+                }
+                batch->food_rows[i] = game->food.position.row;
+                batch->food_columns[i] = game->food.position.column;
+            }
+
+            batch->game_over[i] = game->board_full || CheckForCollisions(game, &game->player);
+            if (batch->game_over[i]) {
+                game_events |= STEP_GAME_OVER;
+            }
+        }
+
+        GameBatchStore(batch, i);
+        if (events) {
+            events[i] = game_events;
+        }
+    }
+}
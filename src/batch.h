@@ -0,0 +1,39 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "game.h"
+
+// Advances many independent games in lockstep. The per-tick player state
+// (heads, directions, food, game over) is kept structure-of-arrays so the
+// head update runs as one branch-free loop over all games; bodies, clones
+// and the path stay in each Game and reuse the single-game code, which keeps
+// every lane bit-for-bit equal to calling GameStep on that game alone.
+// All games in a batch share one board size.
+typedef struct {
+    size_t count;
+    size_t rows;
+    size_t columns;
+    const BoardKernels *kernels;
+    Game *games;
+    int *head_rows;
+    int *head_columns;
+    Direction *dirs;
+    Direction *next_dirs;
+    Direction *next_next_dirs;
+    bool *has_next_next_dirs;
+    int *food_rows;
+    int *food_columns;
+    bool *game_over;
+    bool *eaten;
+} GameBatch;
+
+void InitGameBatch(GameBatch *batch, size_t count, size_t rows, size_t columns, uint64_t seed);
+void FreeGameBatch(GameBatch *batch);
+void GameBatchLoad(GameBatch *batch, size_t i);
+void GameBatchStore(GameBatch *batch, size_t i);
+void GameBatchRestart(GameBatch *batch, size_t i);
+void GameBatchHandleInput(GameBatch *batch, const unsigned *inputs);
+void GameBatchAdvanceHeads(GameBatch *batch);
+void GameBatchStep(GameBatch *batch, unsigned *events);
+
+#endif
@@ -0,0 +1,658 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "batch.h"
+#include "bot.h"
+#include "kernels.h"
+#include "replay.h"
+#include "stb_ds.h"
+#include "timeline.h"
+
+#define BENCH_RUNS 3
+#define HEAD_LANES 4096
+#define HEAD_ITERATIONS 1000
+#define MOVE_ITERATIONS 10000000
+#define STEP_BUDGET 500000
+#define STEP_MAX_STEPS 20000
+#define OP_ITERATIONS 100000
+#define QUERY_ITERATIONS 1000000
+#define FULL_MARK_ITERATIONS 1000
+#define REDUCE_CALLS 64
+#define TIMELINE_STEPS 200000
+#define TIMELINE_SEEKS 1000
+#define TIMELINE_RESUME_STEPS 2000
+#define MAX_RESULTS 256
+
+// One measurement. The suite and case say what was run, metric and unit
+// what came out, so the JSON stays flat and easy to diff between commits.
+typedef struct {
+    const char *suite;
+    char name[48];
+    const char *metric;
+    const char *unit;
+    double value;
+} BenchResult;
+
+BenchResult results[MAX_RESULTS];
+size_t result_count;
+
+void AddResult(const char *suite, const char *name, const char *metric, const char *unit, double value) {
+    if (result_count < MAX_RESULTS) {
+        BenchResult *result = &results[result_count++];
+        *result = (BenchResult) {
+            .suite = suite,
+            .metric = metric,
+            .unit = unit,
+            .value = value
+        };
+        snprintf(result->name, sizeof(result->name), "%s", name);
+    }
+}
+
+// Scripted boards on the default 28x52 board. The player winds along rows
+// in alternating directions, a cycle through every tile, so a snake shorter
+// than the board never runs into itself.
+typedef struct {
+    const char *name;
+    size_t length;
+    size_t clones;
+} Scenario;
+
+const Scenario SCENARIOS[] = {
+    {"short", 3, 0},
+    {"long_500", 500, 0},
+    {"clones_50", 100, 50},
+    {"nearly_full", DEFAULT_ROWS * DEFAULT_COLUMNS * 95 / 100, 0}
+};
+
+typedef enum {
+    OP_SNAKE_DO_STEP,
+    OP_MOVE_CLONES,
+    OP_REDUCE_CLONES,
+    OP_CHECK_FOR_COLLISIONS,
+    OP_PLACE_FOOD_RANDOMLY,
+    OP_MARK_TILES_STEP,
+    OP_MARK_TILES_FULL,
+    OP_COUNT
+} ScenarioOp;
+
+const char *SCENARIO_OP_NAMES[OP_COUNT] = {
+    [OP_SNAKE_DO_STEP] = "SnakeDoStep",
+    [OP_MOVE_CLONES] = "MoveClones",
+    [OP_REDUCE_CLONES] = "ReduceClones",
+    [OP_CHECK_FOR_COLLISIONS] = "CheckForCollisions",
+    [OP_PLACE_FOOD_RANDOMLY] = "PlaceFoodRandomly",
+    [OP_MARK_TILES_STEP] = "GameMarkTiles_step",
+    [OP_MARK_TILES_FULL] = "GameMarkTiles_full"
+};
+
+double Now(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+// Nanoseconds per lane for the branch-free batch head update. The kernel
+// only reads the per-lane arrays, so no games are set up behind them.
+double BenchAdvanceHeads(size_t rows, size_t columns, const BoardKernels *kernels) {
+    GameBatch batch = (GameBatch) {
+        .count = HEAD_LANES,
+        .rows = rows,
+        .columns = columns,
+        .head_rows = calloc(HEAD_LANES, sizeof(int)),
+        .head_columns = calloc(HEAD_LANES, sizeof(int)),
+        .dirs = calloc(HEAD_LANES, sizeof(Direction)),
+        .next_dirs = calloc(HEAD_LANES, sizeof(Direction)),
+        .next_next_dirs = calloc(HEAD_LANES, sizeof(Direction)),
+        .has_next_next_dirs = calloc(HEAD_LANES, sizeof(bool)),
+        .food_rows = calloc(HEAD_LANES, sizeof(int)),
+        .food_columns = calloc(HEAD_LANES, sizeof(int)),
+        .game_over = calloc(HEAD_LANES, sizeof(bool)),
+        .eaten = calloc(HEAD_LANES, sizeof(bool))
+    };
+    for (size_t i = 0; i < HEAD_LANES; i++) {
+        batch.next_dirs[i] = i % 4;
+    }
+
+    kernels->advance_heads(&batch);
+    double start = Now();
+    for (size_t i = 0; i < HEAD_ITERATIONS; i++) {
+        kernels->advance_heads(&batch);
+    }
+    double seconds = Now() - start;
+
+    free(batch.head_rows);
+    free(batch.head_columns);
+    free(batch.dirs);
+    free(batch.next_dirs);
+    free(batch.next_next_dirs);
+    free(batch.has_next_next_dirs);
+    free(batch.food_rows);
+    free(batch.food_columns);
+    free(batch.game_over);
+    free(batch.eaten);
+    return seconds * 1e9 / (HEAD_LANES * (double)HEAD_ITERATIONS);
+}
+
+// Nanoseconds per wrapped move, walking one position around the board
+double BenchMovePosition(size_t rows, size_t columns, const BoardKernels *kernels, int *checksum) {
+    Game game;
+    AllocateBoard(&game, rows, columns);
+
+    Random random;
+    SeedRandom(&random, 1);
+    Direction dirs[1024];
+    for (size_t i = 0; i < 1024; i++) {
+        dirs[i] = RandomBelow(&random, 4);
+    }
+
+    Position position = (Position) {0};
+    double start = Now();
+    for (size_t i = 0; i < MOVE_ITERATIONS; i++) {
+        position = kernels->move_position(&game, position, dirs[i & 1023]);
+    }
+    double seconds = Now() - start;
+    *checksum = position.row * columns + position.column;
+
+    FreeBoard(&game);
+    return seconds * 1e9 / MOVE_ITERATIONS;
+}
+
+// Millions of full game steps per second with the bot playing
+double BenchGameSteps(size_t rows, size_t columns, const BoardKernels *kernels, size_t *checksum) {
+    Game game;
+    AllocateBoard(&game, rows, columns);
+    game.kernels = kernels;
+
+    size_t steps = 0;
+    *checksum = 0;
+    double start = Now();
+    for (size_t i = 0; steps < STEP_BUDGET; i++) {
+        Random bot_random;
+        SeedRandom(&bot_random, ~i);
+        SeedRandom(&game.random, i);
+        ResetGame(&game);
+        for (size_t step = 0; step < STEP_MAX_STEPS && !game.game_over; step++) {
+            SnakeHandleInput(&game.player, BotChooseInput(&game, &bot_random));
+            GameStep(&game);
+            steps++;
+        }
+        *checksum = *checksum * 31 + game.player.length;
+        ClearGame(&game);
+    }
+    double seconds = Now() - start;
+
+    FreeBoard(&game);
+    return steps / seconds / 1e6;
+}
+
+void SerpentineStep(Game *game) {
+    Position head = *SnakeTile(&game->player, 0);
+    bool rightward = head.row % 2 == 0;
+    bool row_end = rightward ? head.column == (int)game->columns - 1 : head.column == 0;
+    game->player.next_dir = row_end ? DOWN_DIRECTION : rightward ? RIGHT_DIRECTION : LEFT_DIRECTION;
+    SnakeDoStep(game, &game->player);
+}
+
+// Grows the player to the scenario length, then spawns each clone ten
+// steps after the last one, growing the player by one as eating does
+void BuildScenario(Game *game, const Scenario *scenario) {
+    SeedRandom(&game->random, 1);
+    ResetGame(game);
+    // The player starts with every segment on one tile; unroll it first
+    for (size_t i = 1; i < game->player.length; i++) {
+        SerpentineStep(game);
+    }
+    while (game->player.length < scenario->length) {
+        SerpentineStep(game);
+        SnakeGrow(game, &game->player);
+    }
+    for (size_t i = 0; i < scenario->clones; i++) {
+        for (size_t step = 0; step < 10; step++) {
+            SerpentineStep(game);
+            MoveClones(game);
+        }
+        SpawnClone(game, &game->player);
+        SnakeGrow(game, &game->player);
+    }
+    GameMarkTiles(game);
+}
+
+// Cost of the Now() pair around a single timed call
+double TimerOverhead(void) {
+    double best = INFINITY;
+    for (size_t i = 0; i < 1000; i++) {
+        double start = Now();
+        best = fmin(best, Now() - start);
+    }
+    return best;
+}
+
+// Nanoseconds per call of one operation on a freshly built scenario. Calls
+// that change the board in a way that cannot go on forever (clones only
+// shrink so far) are timed in short bursts with a rebuild in between.
+double BenchScenarioOp(Game *game, const Scenario *scenario, ScenarioOp op) {
+    BuildScenario(game, scenario);
+
+    size_t calls = 0;
+    double seconds = 0;
+    double start;
+    switch (op) {
+        case OP_SNAKE_DO_STEP:
+            start = Now();
+            for (; calls < OP_ITERATIONS; calls++) {
+                SerpentineStep(game);
+            }
+            seconds = Now() - start;
+            break;
+        case OP_MOVE_CLONES:
+            // Put path ahead of every clone first
+            for (size_t i = 0; i < OP_ITERATIONS; i++) {
+                SerpentineStep(game);
+            }
+            start = Now();
+            for (; calls < OP_ITERATIONS; calls++) {
+                MoveClones(game);
+            }
+            seconds = Now() - start;
+            break;
+        case OP_REDUCE_CLONES:
+            while (calls < OP_ITERATIONS / 10) {
+                start = Now();
+                for (size_t i = 0; i < REDUCE_CALLS; i++) {
+                    ReduceClones(game);
+                }
+                seconds += Now() - start;
+                calls += REDUCE_CALLS;
+                ClearGame(game);
+                BuildScenario(game, scenario);
+            }
+            break;
+        case OP_CHECK_FOR_COLLISIONS: {
+            size_t collisions = 0;
+            start = Now();
+            for (; calls < QUERY_ITERATIONS; calls++) {
+                collisions += CheckForCollisions(game, &game->player);
+            }
+            seconds = Now() - start;
+            // Nothing on these boards overlaps the player's head
+            if (collisions) {
+                fprintf(stderr, "%s: unexpected collision\n", scenario->name);
+            }
+            break;
+        }
+        case OP_PLACE_FOOD_RANDOMLY:
+            start = Now();
+            for (; calls < QUERY_ITERATIONS; calls++) {
+                PlaceFoodRandomly(game, &game->food);
+            }
+            seconds = Now() - start;
+            break;
+        case OP_MARK_TILES_STEP: {
+            // Only the mark is timed, with the timer's own cost taken out
+            double overhead = TimerOverhead();
+            for (; calls < OP_ITERATIONS; calls++) {
+                SerpentineStep(game);
+                MoveClones(game);
+                start = Now();
+                GameMarkTiles(game);
+                seconds += Now() - start - overhead;
+            }
+            break;
+        }
+        case OP_MARK_TILES_FULL:
+            // Every tile recomputed, as a full rebuild of the states would
+            start = Now();
+            for (; calls < FULL_MARK_ITERATIONS; calls++) {
+                for (size_t row = 0; row < game->rows; row++) {
+                    for (size_t column = 0; column < game->columns; column++) {
+                        MarkTileDirty(game, (Position) { .row = row, .column = column });
+                    }
+                }
+                GameMarkTiles(game);
+            }
+            seconds = Now() - start;
+            break;
+        case OP_COUNT:
+            break;
+    }
+
+    ClearGame(game);
+    return fmax(seconds, 0) * 1e9 / calls;
+}
+
+void PrintUsage(const char *program) {
+    fprintf(stderr, "usage: %s [--json] [--runs N] [--replay FILE]\n", program);
+}
+
+// Plays a recording back headless as fast as it goes, file reads included.
+// Returns false when the file cannot be read.
+bool RunReplayBenchmark(const char *path, size_t runs, bool print) {
+    ReplayReader *reader = malloc(sizeof(ReplayReader));
+    double best = INFINITY;
+    size_t steps = 0, restarts = 0, length = 0;
+    for (size_t run = 0; run < runs; run++) {
+        if (!OpenReplayReader(reader, path)) {
+            fprintf(stderr, "%s is not a readable replay\n", path);
+            free(reader);
+            return false;
+        }
+
+        Game game;
+        InitGame(&game, reader->rows, reader->columns, reader->seed);
+        steps = 0;
+        restarts = 0;
+        double start = Now();
+        for (;;) {
+            ReplayAction action = NextReplayAction(reader, &game);
+            if (action == REPLAY_END) {
+                break;
+            }
+            if (action == REPLAY_RESTART) {
+                RestartGame(&game);
+                restarts++;
+                continue;
+            }
+            GameStep(&game);
+            steps++;
+        }
+        best = fmin(best, Now() - start);
+        length = game.player.length;
+
+        FreeGame(&game);
+        CloseReplayReader(reader);
+    }
+    free(reader);
+
+    double rate = steps / best / 1e6;
+    if (print) {
+        printf("%s: %zu steps, %zu restarts, final length %zu, %.2f Msteps/s\n", path, steps, restarts, length, rate);
+    }
+    AddResult("replay", path, "game_steps", "Msteps/s", rate);
+    AddResult("replay", path, "steps", "steps", steps);
+    AddResult("replay", path, "final_length", "segments", length);
+    return true;
+}
+
+// Kernel comparison: generic against specialized kernels on a few boards.
+// Returns false when the two kernel sets play different games.
+bool RunKernelSuite(size_t runs, bool print) {
+    size_t sizes[][2] = {
+        {DEFAULT_ROWS, DEFAULT_COLUMNS},
+        {64, 64},
+        {256, 256},
+        {1024, 1024},
+        {32, 128},
+        {48, 80}
+    };
+
+    if (print) {
+        printf("%-10s %-10s %18s %18s %18s\n", "board", "kernels", "heads ns/lane", "move ns/call", "steps M/s");
+    }
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        size_t rows = sizes[i][0], columns = sizes[i][1];
+        const BoardKernels *candidates[] = {&GENERIC_BOARD_KERNELS, SelectBoardKernels(rows, columns)};
+        // Boards with no specialized set only get the generic row, rather
+        // than the same kernels measured twice
+        size_t candidate_count = candidates[1] == &GENERIC_BOARD_KERNELS ? 1 : 2;
+
+        int move_checksums[2];
+        size_t step_checksums[2];
+        for (size_t k = 0; k < candidate_count; k++) {
+            const BoardKernels *kernels = candidates[k];
+            char board[16];
+            snprintf(board, sizeof(board), "%zux%zu", rows, columns);
+
+            // Best of a few runs, to keep scheduling noise out of the table
+            double heads = INFINITY, move = INFINITY, steps = 0;
+            for (size_t run = 0; run < runs; run++) {
+                heads = fmin(heads, BenchAdvanceHeads(rows, columns, kernels));
+                move = fmin(move, BenchMovePosition(rows, columns, kernels, &move_checksums[k]));
+                steps = fmax(steps, BenchGameSteps(rows, columns, kernels, &step_checksums[k]));
+            }
+            if (print) {
+                printf("%-10s %-10s %18.3f %18.3f %18.2f\n", board, kernels->name, heads, move, steps);
+            }
+
+            char name[48];
+            snprintf(name, sizeof(name), "%s/%s", board, kernels->name);
+            AddResult("kernels", name, "advance_heads", "ns/lane", heads);
+            AddResult("kernels", name, "move_position", "ns/call", move);
+            AddResult("kernels", name, "game_steps", "Msteps/s", steps);
+        }
+
+        // Specialized kernels have to play exactly the same games
+        if (candidate_count == 2 && (move_checksums[0] != move_checksums[1] || step_checksums[0] != step_checksums[1])) {
+            fprintf(stderr, "%s kernels disagree with the generic ones\n", candidates[1]->name);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void RunScenarioSuite(size_t runs, bool print) {
+    Game game;
+    AllocateBoard(&game, DEFAULT_ROWS, DEFAULT_COLUMNS);
+
+    if (print) {
+        printf("\n%-20s", "ns/op");
+        for (size_t s = 0; s < sizeof(SCENARIOS) / sizeof(SCENARIOS[0]); s++) {
+            printf(" %12s", SCENARIOS[s].name);
+        }
+        printf("\n");
+    }
+    for (size_t op = 0; op < OP_COUNT; op++) {
+        if (print) {
+            printf("%-20s", SCENARIO_OP_NAMES[op]);
+        }
+        for (size_t s = 0; s < sizeof(SCENARIOS) / sizeof(SCENARIOS[0]); s++) {
+            double best = INFINITY;
+            for (size_t run = 0; run < runs; run++) {
+                best = fmin(best, BenchScenarioOp(&game, &SCENARIOS[s], op));
+            }
+            if (print) {
+                printf(" %12.2f", best);
+            }
+            AddResult("scenarios", SCENARIOS[s].name, SCENARIO_OP_NAMES[op], "ns/op", best);
+        }
+        if (print) {
+            printf("\n");
+        }
+    }
+
+    FreeBoard(&game);
+}
+
+// The bot plays TIMELINE_STEPS steps through a timeline, restarting on game
+// over, then the timeline is seeked to random steps. Seeks should cost the
+// same however long the run is.
+void RunTimelineSuite(size_t runs, bool print) {
+    double best_step = INFINITY;
+    double best_seek = INFINITY;
+    size_t memory = 0;
+    size_t snapshots = 0;
+    for (size_t run = 0; run < runs; run++) {
+        Game game;
+        InitGame(&game, DEFAULT_ROWS, DEFAULT_COLUMNS, 1);
+        Timeline timeline;
+        InitTimeline(&timeline, &game, TIMELINE_DEFAULT_POOL_SIZE);
+        Random bot_random;
+        SeedRandom(&bot_random, 2);
+
+        double start = Now();
+        for (size_t step = 0; step < TIMELINE_STEPS; step++) {
+            if (game.game_over) {
+                RestartGame(&game);
+                TimelineRecordRestart(&timeline);
+            }
+            SnakeHandleInput(&game.player, BotChooseInput(&game, &bot_random));
+            TimelineStep(&timeline, &game);
+        }
+        best_step = fmin(best_step, (Now() - start) * 1e9 / TIMELINE_STEPS);
+        memory = TimelineMemoryUsed(&timeline);
+        snapshots = arrlen(timeline.snapshots);
+
+        Random seek_random;
+        SeedRandom(&seek_random, 3);
+        uint64_t first = TimelineFirstStep(&timeline);
+        start = Now();
+        for (size_t i = 0; i < TIMELINE_SEEKS; i++) {
+            TimelineSeek(&timeline, &game, first + RandomNext(&seek_random) % (timeline.step - first + 1));
+        }
+        best_seek = fmin(best_seek, (Now() - start) * 1e6 / TIMELINE_SEEKS);
+
+        FreeTimeline(&timeline);
+        FreeGame(&game);
+    }
+
+    if (print) {
+        printf("\ntimeline: %d steps at %.1f ns/step, %zu snapshots in %.2f MiB, %.1f us/seek\n",
+            TIMELINE_STEPS, best_step, snapshots, memory / 1048576.0, best_seek);
+    }
+    AddResult("timeline", "bot", "step", "ns/op", best_step);
+    AddResult("timeline", "bot", "seek", "us/op", best_seek);
+    AddResult("timeline", "bot", "snapshots", "snapshots", snapshots);
+    AddResult("timeline", "bot", "snapshot_memory", "bytes", memory);
+}
+
+// Restarts at a game over, seeks back and then to the live end again, and
+// plays on for a while without restarting. The seek replaces the restarted
+// game, so the restart must not be recorded: replaying every input from the
+// start has to end where the live game did.
+bool CheckTimelineRestartSeek(bool print) {
+    Game game;
+    InitGame(&game, DEFAULT_ROWS, DEFAULT_COLUMNS, 1);
+    Timeline timeline;
+    InitTimeline(&timeline, &game, TIMELINE_DEFAULT_POOL_SIZE);
+    Random bot_random;
+    SeedRandom(&bot_random, 2);
+
+    while (!game.game_over) {
+        SnakeHandleInput(&game.player, BotChooseInput(&game, &bot_random));
+        TimelineStep(&timeline, &game);
+    }
+    RestartGame(&game);
+    TimelineRecordRestart(&timeline);
+    uint64_t live_end = timeline.step;
+    TimelineSeek(&timeline, &game, live_end > 10 ? live_end - 10 : 0);
+    TimelineSeek(&timeline, &game, live_end);
+    for (size_t step = 0; step < TIMELINE_RESUME_STEPS; step++) {
+        if (game.game_over && step >= TIMELINE_RESUME_STEPS / 2) {
+            RestartGame(&game);
+            TimelineRecordRestart(&timeline);
+        }
+        SnakeHandleInput(&game.player, BotChooseInput(&game, &bot_random));
+        TimelineStep(&timeline, &game);
+    }
+
+    Game replayed;
+    InitGame(&replayed, DEFAULT_ROWS, DEFAULT_COLUMNS, 1);
+    for (uint64_t step = 0; step < timeline.step; step++) {
+        uint8_t input = timeline.inputs[step - timeline.input_base];
+        if (input & TIMELINE_INPUT_RESTART) {
+            RestartGame(&replayed);
+        }
+        UnpackSnakeInput(&replayed.player, input);
+        GameStep(&replayed);
+    }
+
+    TimelineBlob live = {0};
+    TimelineBlob expected = {0};
+    SerializeGame(&game, &live);
+    SerializeGame(&replayed, &expected);
+    bool match = timeline.input_base == 0 && arrlen(live.bytes) == arrlen(expected.bytes)
+        && memcmp(live.bytes, expected.bytes, arrlen(live.bytes)) == 0;
+    if (!match) {
+        fprintf(stderr, "timeline: seeking across a restart diverged from the recorded inputs\n");
+    } else if (print) {
+        printf("timeline: seek and resume across a restart matches a replay from the start\n");
+    }
+
+    arrfree(live.bytes);
+    arrfree(expected.bytes);
+    FreeGame(&replayed);
+    FreeTimeline(&timeline);
+    FreeGame(&game);
+    return match;
+}
+
+// Case names can be file paths, so quotes, backslashes and control
+// characters get escaped
+void PrintJsonString(const char *text) {
+    putchar('"');
+    for (; *text; text++) {
+        unsigned char c = *text;
+        if (c == '"' || c == '\\') {
+            printf("\\%c", c);
+        } else if (c == '\n') {
+            printf("\\n");
+        } else if (c == '\t') {
+            printf("\\t");
+        } else if (c < 0x20) {
+            printf("\\u%04x", c);
+        } else {
+            putchar(c);
+        }
+    }
+    putchar('"');
+}
+
+void PrintJson(size_t runs) {
+    printf("{\n");
+    printf("  \"benchmark\": \"snake-bench\",\n");
+    printf("  \"version\": 1,\n");
+    printf("  \"runs\": %zu,\n", runs);
+    printf("  \"results\": [\n");
+    for (size_t i = 0; i < result_count; i++) {
+        BenchResult *result = &results[i];
+        printf("    {\"suite\": \"%s\", \"case\": ", result->suite);
+        PrintJsonString(result->name);
+        printf(", \"metric\": \"%s\", \"unit\": \"%s\", \"value\": %.4f}%s\n",
+            result->metric, result->unit, result->value, i + 1 < result_count ? "," : "");
+    }
+    printf("  ]\n");
+    printf("}\n");
+}
+
+int main(int argc, char **argv) {
+    bool json = false;
+    size_t runs = BENCH_RUNS;
+    const char *replay_path = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0) {
+            json = true;
+        } else if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 0) {
+            runs = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replay_path = argv[++i];
+        } else {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    // A replay is benchmarked on its own
+    if (replay_path) {
+        if (!RunReplayBenchmark(replay_path, runs, !json)) {
+            return 1;
+        }
+    } else {
+        if (!RunKernelSuite(runs, !json)) {
+            return 1;
+        }
+        RunScenarioSuite(runs, !json);
+        RunTimelineSuite(runs, !json);
+        if (!CheckTimelineRestartSeek(!json)) {
+            return 1;
+        }
+    }
+    if (json) {
+        PrintJson(runs);
+    }
+
+    return 0;
+}
@@ -0,0 +1,71 @@
+#include <limits.h>
+#include <stdlib.h>
+
+#include "bot.h"
+
+Direction OppositeDirection(Direction dir) {
+    switch (dir) {
+        case UP_DIRECTION:
+            return DOWN_DIRECTION;
+        case DOWN_DIRECTION:
+            return UP_DIRECTION;
+        case LEFT_DIRECTION:
+            return RIGHT_DIRECTION;
+        case RIGHT_DIRECTION:
+            return LEFT_DIRECTION;
+    }
+    return dir;
+}
+
+unsigned DirectionInput(Direction dir) {
+    switch (dir) {
+        case UP_DIRECTION:
+            return INPUT_UP;
+        case DOWN_DIRECTION:
+            return INPUT_DOWN;
+        case LEFT_DIRECTION:
+            return INPUT_LEFT;
+        case RIGHT_DIRECTION:
+            return INPUT_RIGHT;
+    }
+    return 0;
+}
+
+int WrappedDistance(Game *game, Position a, Position b) {
+    int board_rows = game->rows, board_columns = game->columns;
+    int rows = abs(a.row - b.row);
+    int columns = abs(a.column - b.column);
+    if (rows > board_rows - rows) rows = board_rows - rows;
+    if (columns > board_columns - columns) columns = board_columns - columns;
+    return rows + columns;
+}
+
+// Greedy player for headless runs: heads for the food along the shortest
+// wrapped route, avoids tiles that are occupied right now and breaks ties
+// with the caller's random stream.
+unsigned BotChooseInput(Game *game, Random *random) {
+    Snake *player = &game->player;
+    Position head = *SnakeTile(player, 0);
+
+    Direction best_dir = player->next_dir;
+    int best_score = INT_MIN;
+    for (Direction dir = UP_DIRECTION; dir <= RIGHT_DIRECTION; dir++) {
+        if (dir == OppositeDirection(player->dir)) {
+            continue;
+        }
+
+        Position next = MovePosition(game, head, dir);
+        int score = -WrappedDistance(game, next, game->food.position);
+        if (game->occupancy[TileIndex(game, next)] > 0) {
+            score -= game->rows + game->columns;
+        }
+        score = score * 4 + RandomBelow(random, 4);
+
+        if (score > best_score) {
+            best_score = score;
+            best_dir = dir;
+        }
+    }
+
+    return DirectionInput(best_dir);
+}
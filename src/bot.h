@@ -0,0 +1,11 @@
+#ifndef BOT_H
+#define BOT_H
+
+#include "game.h"
+
+Direction OppositeDirection(Direction dir);
+unsigned DirectionInput(Direction dir);
+int WrappedDistance(Game *game, Position a, Position b);
+unsigned BotChooseInput(Game *game, Random *random);
+
+#endif
@@ -0,0 +1,172 @@
+#include <stdalign.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bot.h"
+#include "game.h"
+#include "pool.h"
+#include "stb_ds.h"
+
+typedef struct {
+    size_t steps;
+    size_t length;
+    size_t food;
+    size_t clones;
+    size_t clone_tiles;
+    bool died;
+    bool board_full;
+} GameResult;
+
+// Each worker's game starts on its own cache line and fills whole lines, so
+// the fields every step writes (random, free_count, food, the player) are
+// never shared with a neighbouring worker's core
+typedef struct {
+    alignas(CACHE_LINE_SIZE) Game game;
+} WorkerGame;
+
+typedef struct {
+    uint64_t seed;
+    size_t rows;
+    size_t columns;
+    size_t max_steps;
+    WorkerGame *games;
+    GameResult *results;
+} Farm;
+
+void PlayGame(void *context, size_t task, size_t worker) {
+    Farm *farm = context;
+    Game *game = &farm->games[worker].game;
+    GameResult *result = &farm->results[task];
+
+    // Seeds depend only on the farm seed and the game index, so results do
+    // not change with the number of threads or the order of scheduling.
+    uint64_t game_seed = SplitMix64(farm->seed) + task;
+    Random bot_random;
+    SeedRandom(&bot_random, ~game_seed);
+    SeedRandom(&game->random, game_seed);
+    ResetGame(game);
+
+    *result = (GameResult) {0};
+    while (!game->game_over && result->steps < farm->max_steps) {
+        SnakeHandleInput(&game->player, BotChooseInput(game, &bot_random));
+        if (GameStep(game) & STEP_FOOD_EATEN) {
+            result->food++;
+        }
+        result->steps++;
+    }
+
+    result->length = game->player.length;
+    result->board_full = game->board_full;
+    result->died = game->game_over && !game->board_full;
+    result->clones = arrlen(game->clones);
+    for (size_t i = 0; i < result->clones; i++) {
+        result->clone_tiles += game->clones[i].snake.length;
+    }
+
+    ClearGame(game);
+}
+
+bool ParseSize(const char *text, size_t *value) {
+    char *end;
+    unsigned long long parsed = strtoull(text, &end, 10);
+    if (*text == '\0' || *end != '\0') {
+        return false;
+    }
+    *value = parsed;
+    return true;
+}
+
+void PrintUsage(const char *program) {
+    fprintf(stderr, "usage: %s [--games N] [--threads N] [--max-steps N] [--seed N] [--rows N] [--columns N]\n", program);
+    fprintf(stderr, "board sides run from %d to %d\n", MIN_BOARD_SIZE, MAX_BOARD_SIZE);
+}
+
+int main(int argc, char **argv) {
+    size_t game_count = 10000;
+    size_t thread_count = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t max_steps = 100000;
+    size_t seed = 1;
+    size_t rows = DEFAULT_ROWS;
+    size_t columns = DEFAULT_COLUMNS;
+
+    for (int i = 1; i < argc; i++) {
+        size_t *option = nullptr;
+        if (strcmp(argv[i], "--games") == 0) option = &game_count;
+        else if (strcmp(argv[i], "--threads") == 0) option = &thread_count;
+        else if (strcmp(argv[i], "--max-steps") == 0) option = &max_steps;
+        else if (strcmp(argv[i], "--seed") == 0) option = &seed;
+        else if (strcmp(argv[i], "--rows") == 0) option = &rows;
+        else if (strcmp(argv[i], "--columns") == 0) option = &columns;
+
+        if (!option || i + 1 >= argc || !ParseSize(argv[i + 1], option)) {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+        i++;
+    }
+    if (thread_count == 0) {
+        thread_count = 1;
+    }
+    if (rows < MIN_BOARD_SIZE || rows > MAX_BOARD_SIZE || columns < MIN_BOARD_SIZE || columns > MAX_BOARD_SIZE) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    Farm farm = (Farm) {
+        .seed = seed,
+        .rows = rows,
+        .columns = columns,
+        .max_steps = max_steps,
+        .games = aligned_alloc(CACHE_LINE_SIZE, sizeof(WorkerGame) * thread_count),
+        .results = calloc(game_count, sizeof(GameResult))
+    };
+
+    memset(farm.games, 0, sizeof(WorkerGame) * thread_count);
+
+    // Each worker reuses one board for all of its games
+    for (size_t i = 0; i < thread_count; i++) {
+        AllocateBoard(&farm.games[i].game, rows, columns);
+    }
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    RunTasks(thread_count, game_count, PlayGame, &farm);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) * 1e-9;
+
+    size_t total_steps = 0, total_length = 0, total_food = 0, total_clones = 0, total_clone_tiles = 0;
+    size_t max_length = 0, max_clones = 0, deaths = 0, boards_filled = 0;
+    for (size_t i = 0; i < game_count; i++) {
+        GameResult *result = &farm.results[i];
+        total_steps += result->steps;
+        total_length += result->length;
+        total_food += result->food;
+        total_clones += result->clones;
+        total_clone_tiles += result->clone_tiles;
+        if (result->length > max_length) max_length = result->length;
+        if (result->clones > max_clones) max_clones = result->clones;
+        if (result->died) deaths++;
+        if (result->board_full) boards_filled++;
+    }
+
+    double games = game_count > 0 ? game_count : 1;
+    printf("games:        %zu on %zu threads, seed %zu, %zux%zu board\n", game_count, thread_count, seed, rows, columns);
+    printf("time:         %.3f s, %.2f M steps/s\n", seconds, total_steps / seconds / 1e6);
+    printf("steps:        %zu total, %.1f per game\n", total_steps, total_steps / games);
+    printf("endings:      %zu deaths, %zu filled the board, %zu reached --max-steps\n", deaths, boards_filled, game_count - deaths - boards_filled);
+    printf("length:       %.2f mean, %zu max\n", total_length / games, max_length);
+    printf("food eaten:   %.2f mean\n", total_food / games);
+    printf("clones:       %.2f mean, %zu max at end of game\n", total_clones / games, max_clones);
+    printf("clone tiles:  %.2f mean at end of game\n", total_clone_tiles / games);
+
+    for (size_t i = 0; i < thread_count; i++) {
+        FreeBoard(&farm.games[i].game);
+    }
+    free(farm.games);
+    free(farm.results);
+
+    return 0;
+}
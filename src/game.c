@@ -0,0 +1,465 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "game.h"
+#include "kernels.h"
+#include "stb_ds.h"
+
+// Zeroed and rounded up to whole cache lines, so every array starts on one
+void *AllocateTiles(size_t count, size_t size) {
+    size_t bytes = (count * size + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+    void *tiles = aligned_alloc(CACHE_LINE_SIZE, bytes);
+    memset(tiles, 0, bytes);
+    return tiles;
+}
+
+void AllocateBoard(Game *game, size_t rows, size_t columns) {
+    size_t count = rows * columns;
+    game->rows = rows;
+    game->columns = columns;
+    game->kernels = SelectBoardKernels(rows, columns);
+
+    TileGrid *grid = &game->tileGrid;
+    grid->timers = AllocateTiles(count, sizeof(float));
+    grid->angles = AllocateTiles(count, sizeof(float));
+    grid->states = AllocateTiles(count, sizeof(uint8_t));
+    grid->visited = AllocateTiles(count, sizeof(bool));
+    grid->dirty = AllocateTiles(count, sizeof(bool));
+    grid->dirty_tiles = AllocateTiles(count, sizeof(uint32_t));
+    grid->updated_tiles = AllocateTiles(count, sizeof(uint32_t));
+
+    game->occupancy = AllocateTiles(count, sizeof(uint32_t));
+    game->player_occupancy = AllocateTiles(count, sizeof(uint32_t));
+    game->free_tiles = AllocateTiles(count, sizeof(uint32_t));
+    game->free_index = AllocateTiles(count, sizeof(uint32_t));
+}
+
+void FreeBoard(Game *game) {
+    TileGrid *grid = &game->tileGrid;
+    free(grid->timers);
+    free(grid->angles);
+    free(grid->states);
+    free(grid->visited);
+    free(grid->dirty);
+    free(grid->dirty_tiles);
+    free(grid->updated_tiles);
+
+    free(game->occupancy);
+    free(game->player_occupancy);
+    free(game->free_tiles);
+    free(game->free_index);
+}
+
+size_t TileIndex(Game *game, Position position) {
+    return position.row * game->columns + position.column;
+}
+
+void InitTileGrid(Game *game) {
+    TileGrid *grid = &game->tileGrid;
+    for (size_t row = 0; row < game->rows; row++) {
+        // Timers start at (row + 1) * pitch * (column + 1) * pitch, taken
+        // modulo 2 PI: only the phase matters to the animation, and small
+        // timers stay precise enough to advance every frame
+        double step = fmod((row + 1) * (TILE_SIZE + TILE_SPACING) * (TILE_SIZE + TILE_SPACING), 2 * M_PI);
+        double timer = 0;
+        for (size_t column = 0; column < game->columns; column++) {
+            size_t i = row * game->columns + column;
+            timer += step;
+            if (timer >= 2 * M_PI) {
+                timer -= 2 * M_PI;
+            }
+            grid->states[i] = EMPTY_TILE;
+            grid->angles[i] = 0;
+            grid->timers[i] = timer;
+            grid->visited[i] = false;
+            grid->dirty[i] = true;
+            grid->dirty_tiles[i] = i;
+        }
+    }
+    grid->dirty_count = game->rows * game->columns;
+    grid->updated_count = 0;
+}
+
+void MarkTileDirty(Game *game, Position position) {
+    TileGrid *grid = &game->tileGrid;
+    uint32_t tile = TileIndex(game, position);
+    if (!grid->dirty[tile]) {
+        grid->dirty[tile] = true;
+        grid->dirty_tiles[grid->dirty_count++] = tile;
+    }
+}
+
+// Food wins over snakes, a tile with both the player and a clone on it is
+// shared, and empty tiles remember whether anything has been on them
+void UpdateTileState(Game *game, uint32_t tile) {
+    TileGrid *grid = &game->tileGrid;
+    uint32_t total = game->occupancy[tile];
+    uint32_t player = game->player_occupancy[tile];
+
+    if (game->food.position.row >= 0 && TileIndex(game, game->food.position) == tile) {
+        grid->states[tile] = game->food.value;
+    } else if (player > 0 && total > player) {
+        grid->states[tile] = CLONE_AND_PLAYER_TILE;
+    } else if (player > 0) {
+        grid->states[tile] = PLAYER_TILE;
+    } else if (total > 0) {
+        grid->states[tile] = CLONE_TILE;
+    } else {
+        grid->states[tile] = grid->visited[tile] ? VISITED_TILE : EMPTY_TILE;
+    }
+}
+
+size_t SnakeCapacityFor(size_t length) {
+    size_t capacity = 4;
+    while (capacity < length) {
+        capacity *= 2;
+    }
+    return capacity;
+}
+
+// Body is a ring buffer with a power of two capacity: index 0 is the head
+// and index length-1 is the tail, so stepping and shrinking never move tiles.
+Position *SnakeTile(Snake *snake, size_t i) {
+    return &snake->tiles[(snake->head + i) & (snake->capacity - 1)];
+}
+
+void InitFreeTiles(Game *game) {
+    game->free_count = game->rows * game->columns;
+    for (size_t i = 0; i < game->free_count; i++) {
+        game->free_index[i] = i;
+        game->free_tiles[i] = i;
+    }
+}
+
+// Every body segment of the player and the clones is counted in
+// game->occupancy, so the helpers below keep it in sync as bodies change.
+// A tile leaves the free list when its first segment arrives and comes back
+// when its last one leaves.
+void OccupyTile(Game *game, Snake *snake, Position position) {
+    size_t tile = TileIndex(game, position);
+    MarkTileDirty(game, position);
+    // Set here rather than when the state is recomputed, so the trail does
+    // not depend on how often GameMarkTiles runs
+    game->tileGrid.visited[tile] = true;
+    game->player_occupancy[tile] += snake->value == PLAYER_TILE;
+    if (game->occupancy[tile]++ == 0) {
+        uint32_t index = game->free_index[tile];
+        uint32_t last = game->free_tiles[--game->free_count];
+        game->free_tiles[index] = last;
+        game->free_index[last] = index;
+    }
+}
+
+void ReleaseTile(Game *game, Snake *snake, Position position) {
+    size_t tile = TileIndex(game, position);
+    MarkTileDirty(game, position);
+    game->player_occupancy[tile] -= snake->value == PLAYER_TILE;
+    if (--game->occupancy[tile] == 0) {
+        game->free_index[tile] = game->free_count;
+        game->free_tiles[game->free_count++] = tile;
+    }
+}
+
+void SnakeAdvance(Game *game, Snake *snake, Position position) {
+    ReleaseTile(game, snake, *SnakeTile(snake, snake->length - 1));
+    snake->head = (snake->head + snake->capacity - 1) & (snake->capacity - 1);
+    snake->tiles[snake->head] = position;
+    OccupyTile(game, snake, position);
+}
+
+void SnakePushTail(Game *game, Snake *snake, Position position) {
+    if (snake->length == snake->capacity) {
+        size_t capacity = snake->capacity * 2;
+        Position *tiles = malloc(sizeof(Position) * capacity);
+        for (size_t i = 0; i < snake->length; i++) {
+            tiles[i] = *SnakeTile(snake, i);
+        }
+        free(snake->tiles);
+        snake->tiles = tiles;
+        snake->head = 0;
+        snake->capacity = capacity;
+    }
+    snake->length++;
+    *SnakeTile(snake, snake->length - 1) = position;
+    OccupyTile(game, snake, position);
+}
+
+void SnakePopTail(Game *game, Snake *snake) {
+    ReleaseTile(game, snake, *SnakeTile(snake, snake->length - 1));
+    snake->length--;
+}
+
+void FreeSnake(Snake *snake) {
+    free(snake->tiles);
+    snake->tiles = nullptr;
+    snake->length = 0;
+}
+
+void InitSnake(Game *game, Snake *snake, TileState value, size_t row, size_t column, size_t length) {
+    snake->capacity = SnakeCapacityFor(length);
+    snake->tiles = malloc(sizeof(Position) * snake->capacity);
+    snake->head = 0;
+    snake->length = 0;
+    snake->value = value;
+    snake->dir = RIGHT_DIRECTION;
+    snake->next_dir = RIGHT_DIRECTION;
+    snake->next_next_dir = RIGHT_DIRECTION;
+    snake->has_next_next_dir = false;
+
+    Position start_position = (Position) {
+        .row = row,
+        .column = column
+    };
+
+    for (size_t i = 0; i < length; i++) {
+        SnakePushTail(game, snake, start_position);
+    }
+}
+
+void InitPlayerPath(PlayerPath *path, Position start) {
+    path->start = start;
+    path->chunks = nullptr;
+    path->length = 1;
+}
+
+void PlayerPathPush(PlayerPath *path, Direction dir) {
+    size_t step = path->length - 1;
+    if (step % PATH_CHUNK_STEPS == 0) {
+        arrpush(path->chunks, calloc(PATH_CHUNK_STEPS / 4, 1));
+    }
+    uint8_t *chunk = path->chunks[step / PATH_CHUNK_STEPS];
+    size_t offset = step % PATH_CHUNK_STEPS;
+    chunk[offset / 4] |= dir << (offset % 4 * 2);
+    path->length++;
+}
+
+// Direction taken to get from position idx-1 to position idx, for idx >= 1
+Direction PlayerPathDirection(PlayerPath *path, size_t idx) {
+    size_t step = idx - 1;
+    uint8_t *chunk = path->chunks[step / PATH_CHUNK_STEPS];
+    size_t offset = step % PATH_CHUNK_STEPS;
+    return (chunk[offset / 4] >> (offset % 4 * 2)) & 3;
+}
+
+void FreePlayerPath(PlayerPath *path) {
+    size_t chunks_len = arrlen(path->chunks);
+    for (size_t i = 0; i < chunks_len; i++) {
+        free(path->chunks[i]);
+    }
+    arrfree(path->chunks);
+    path->length = 0;
+}
+
+// Returns false when every tile is taken by a snake
+bool PlaceFoodRandomly(Game *game, Food *food) {
+    if (food->position.row >= 0) {
+        MarkTileDirty(game, food->position);
+    }
+    if (game->free_count == 0) {
+        food->position.row = -1;
+        food->position.column = -1;
+        return false;
+    }
+
+    uint32_t tile = game->free_tiles[RandomBelow(&game->random, game->free_count)];
+    food->position.row = tile / game->columns;
+    food->position.column = tile % game->columns;
+    MarkTileDirty(game, food->position);
+    return true;
+}
+
+void InitFood(Game *game, Food *food) {
+    food->value = FOOD_TILE;
+    food->position = (Position) { .row = -1, .column = -1 };
+    PlaceFoodRandomly(game, food);
+}
+
+// Board sizes run from MIN_BOARD_SIZE to MAX_BOARD_SIZE on each side
+void InitGame(Game *game, size_t rows, size_t columns, uint64_t seed) {
+    AllocateBoard(game, rows, columns);
+    SeedRandom(&game->random, seed);
+    ResetGame(game);
+}
+
+// Starts a new game, carrying on with the game's current random stream
+void ResetGame(Game *game) {
+    game->clones = nullptr;
+    game->game_over = false;
+    game->board_full = false;
+    memset(game->occupancy, 0, sizeof(uint32_t) * game->rows * game->columns);
+    memset(game->player_occupancy, 0, sizeof(uint32_t) * game->rows * game->columns);
+    InitFreeTiles(game);
+
+    InitTileGrid(game);
+    InitSnake(game, &game->player, PLAYER_TILE, game->rows / 2 - 1, game->columns / 2 - 2, 3);
+    InitPlayerPath(&game->player_path, *SnakeTile(&game->player, 0));
+    InitFood(game, &game->food);
+}
+
+// Frees what ResetGame set up; the board itself stays
+void ClearGame(Game *game) {
+    FreeSnake(&game->player);
+    size_t clones_len = arrlen(game->clones);
+    for (size_t i = 0; i < clones_len; i++) {
+        FreeSnake(&game->clones[i].snake);
+    }
+    arrfree(game->clones);
+    FreePlayerPath(&game->player_path);
+}
+
+void FreeGame(Game *game) {
+    ClearGame(game);
+    FreeBoard(game);
+}
+
+void RestartGame(Game *game) {
+    ClearGame(game);
+    ResetGame(game);
+}
+
+// Brings the states of the tiles touched since the last call up to date
+void GameMarkTiles(Game *game) {
+    TileGrid *grid = &game->tileGrid;
+    for (size_t i = 0; i < grid->dirty_count; i++) {
+        uint32_t tile = grid->dirty_tiles[i];
+        grid->dirty[tile] = false;
+        grid->updated_tiles[i] = tile;
+        UpdateTileState(game, tile);
+    }
+    grid->updated_count = grid->dirty_count;
+    grid->dirty_count = 0;
+}
+
+Position MovePosition(Game *game, Position position, Direction dir) {
+    return game->kernels->move_position(game, position, dir);
+}
+
+void SnakeDoStep(Game *game, Snake *snake) {
+    snake->dir = snake->next_dir;
+
+    Position new_head = MovePosition(game, *SnakeTile(snake, 0), snake->dir);
+    SnakeAdvance(game, snake, new_head);
+    PlayerPathPush(&game->player_path, snake->dir);
+
+    if (snake->has_next_next_dir) {
+        snake->next_dir = snake->next_next_dir;
+        snake->has_next_next_dir = false;
+    }
+}
+
+void HandleDirectionInput(Direction dir, Direction *next_dir, Direction *next_next_dir, bool *has_next_next_dir, unsigned input) {
+    if (dir == *next_dir) {
+        if ((input & INPUT_LEFT) && dir != RIGHT_DIRECTION) {
+            *next_dir = LEFT_DIRECTION;
+        }
+        if ((input & INPUT_RIGHT) && dir != LEFT_DIRECTION) {
+            *next_dir = RIGHT_DIRECTION;
+        }
+        if ((input & INPUT_UP) && dir != DOWN_DIRECTION) {
+            *next_dir = UP_DIRECTION;
+        }
+        if ((input & INPUT_DOWN) && dir != UP_DIRECTION) {
+            *next_dir = DOWN_DIRECTION;
+        }
+    } else {
+        if ((input & INPUT_LEFT) && *next_dir != RIGHT_DIRECTION) {
+            *has_next_next_dir = true;
+            *next_next_dir = LEFT_DIRECTION;
+        }
+        if ((input & INPUT_RIGHT) && *next_dir != LEFT_DIRECTION) {
+            *has_next_next_dir = true;
+            *next_next_dir = RIGHT_DIRECTION;
+        }
+        if ((input & INPUT_UP) && *next_dir != DOWN_DIRECTION) {
+            *has_next_next_dir = true;
+            *next_next_dir = UP_DIRECTION;
+        }
+        if ((input & INPUT_DOWN) && *next_dir != UP_DIRECTION) {
+            *has_next_next_dir = true;
+            *next_next_dir = DOWN_DIRECTION;
+        }
+    }
+}
+
+void SnakeHandleInput(Snake *snake, unsigned input) {
+    HandleDirectionInput(snake->dir, &snake->next_dir, &snake->next_next_dir, &snake->has_next_next_dir, input);
+}
+
+void SnakeGrow(Game *game, Snake *snake) {
+    Position last = *SnakeTile(snake, snake->length - 1);
+    SnakePushTail(game, snake, last);
+}
+
+void SpawnClone(Game *game, Snake *player) {
+    Snake snake;
+    size_t row = game->player_path.start.row;
+    size_t column = game->player_path.start.column;
+    size_t length = player->length;
+    InitSnake(game, &snake, CLONE_TILE, row, column, length);
+
+    SnakeClone clone = (SnakeClone) {
+        .snake = snake,
+        .player_path_idx = 0
+    };
+
+    arrpush(game->clones, clone);
+}
+
+void MoveClones(Game *game) {
+    game->kernels->move_clones(game);
+}
+
+void ReduceClones(Game *game) {
+    size_t clones_len = arrlen(game->clones);
+    for (int i = clones_len - 1; i >= 0; i--) {
+        SnakeClone *clone = &game->clones[i];
+
+        SnakePopTail(game, &clone->snake);
+
+        if (clone->snake.length == 0) {
+            FreeSnake(&clone->snake);
+            arrdelswap(game->clones, i);
+        }
+    }
+}
+
+bool CheckForCollisions(Game *game, Snake *player) {
+    Position *head = SnakeTile(player, 0);
+    // The head itself is one of the segments counted on its tile
+    return game->occupancy[TileIndex(game, *head)] > 1;
+}
+
+// Returns false when the board filled up and no new food could be placed
+bool GameEatFood(Game *game) {
+    ReduceClones(game);
+    SpawnClone(game, &game->player);
+    SnakeGrow(game, &game->player);
+    game->board_full = !PlaceFoodRandomly(game, &game->food);
+    return !game->board_full;
+}
+
+unsigned GameStep(Game *game) {
+    unsigned events = 0;
+
+    MoveClones(game);
+
+    if (!game->game_over) {
+        SnakeDoStep(game, &game->player);
+
+        Position *head = SnakeTile(&game->player, 0);
+        if (head->row == game->food.position.row && head->column == game->food.position.column) {
+            events |= STEP_FOOD_EATEN;
+            if (!GameEatFood(game)) {
+                events |= STEP_BOARD_FULL;
+            }
+        }
+
+        game->game_over = game->board_full || CheckForCollisions(game, &game->player);
+        if (game->game_over) {
+            events |= STEP_GAME_OVER;
+        }
+    }
+
+    return events;
+}
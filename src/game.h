@@ -0,0 +1,183 @@
+#ifndef GAME_H
+#define GAME_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "random.h"
+
+#define DEFAULT_ROWS 28
+#define DEFAULT_COLUMNS 52
+#define MIN_BOARD_SIZE 4
+#define MAX_BOARD_SIZE 1024
+#define TILE_SIZE 16
+#define TILE_SPACING 2
+
+#define PATH_CHUNK_STEPS 4096
+
+#define CACHE_LINE_SIZE 64
+
+typedef enum {
+    EMPTY_TILE,
+    VISITED_TILE,
+    PLAYER_TILE,
+    FOOD_TILE,
+    CLONE_TILE,
+    CLONE_AND_PLAYER_TILE
+} TileState;
+
+// Per-tile data, one flat row-major array per field (index row * columns +
+// column), so the animation kernels stream through timers and angles
+// without touching the rest.
+//
+// States are kept up to date incrementally: any tile a snake enters or
+// leaves, or the food moves to or from, is queued in dirty_tiles, and
+// GameMarkTiles recomputes only those. The tiles it recomputed stay listed
+// in updated_tiles until the next call, for renderers that upload changes.
+typedef struct {
+    float *timers;
+    float *angles;
+    uint8_t *states; // TileState
+    bool *visited;
+    bool *dirty;
+    uint32_t *dirty_tiles;
+    size_t dirty_count;
+    uint32_t *updated_tiles;
+    size_t updated_count;
+} TileGrid;
+
+typedef struct {
+    int row;
+    int column;
+} Position;
+
+typedef enum {
+    UP_DIRECTION,
+    DOWN_DIRECTION,
+    LEFT_DIRECTION,
+    RIGHT_DIRECTION
+} Direction;
+
+// Direction keys pressed since the last call to SnakeHandleInput, as a mask
+typedef enum {
+    INPUT_LEFT = 1 << 0,
+    INPUT_RIGHT = 1 << 1,
+    INPUT_UP = 1 << 2,
+    INPUT_DOWN = 1 << 3
+} InputCommand;
+
+// What happened during a GameStep, as a mask
+typedef enum {
+    STEP_FOOD_EATEN = 1 << 0,
+    STEP_GAME_OVER = 1 << 1,
+    STEP_BOARD_FULL = 1 << 2
+} StepEvent;
+
+typedef struct {
+    Position *tiles;
+    size_t head;
+    size_t length;
+    size_t capacity;
+    TileState value;
+    Direction dir;
+    Direction next_dir;
+    Direction next_next_dir;
+    bool has_next_next_dir;
+} Snake;
+
+typedef struct {
+    Snake snake;
+    size_t player_path_idx;
+} SnakeClone;
+
+// Every clone replays the player's path from the very first position, so
+// the whole history stays live. It is stored as the start position plus one
+// 2-bit direction per step, in fixed size chunks that are never reallocated.
+typedef struct {
+    Position start;
+    uint8_t **chunks;
+    size_t length;
+} PlayerPath;
+
+typedef struct BoardKernels BoardKernels;
+
+// Food sits at row -1 once the board is full and nothing can be placed
+typedef struct {
+    Position position;
+    TileState value;
+} Food;
+
+// The board size is fixed when the game is created. Every per-tile array,
+// here and in the TileGrid, is a flat row-major heap block starting on a
+// cache line.
+typedef struct {
+    size_t rows;
+    size_t columns;
+    const BoardKernels *kernels;
+    bool game_over;
+    bool board_full;
+    Random random;
+    TileGrid tileGrid;
+    uint32_t *occupancy;
+    // The player's share of occupancy, which tells player, clone and shared
+    // tiles apart
+    uint32_t *player_occupancy;
+    // Tiles with no snake segment on them, as a dense list plus the index
+    // of each free tile in that list, so food placement is a single draw.
+    uint32_t *free_tiles;
+    uint32_t *free_index;
+    size_t free_count;
+    Snake player;
+    Food food;
+    PlayerPath player_path;
+    SnakeClone *clones;
+} Game;
+
+void *AllocateTiles(size_t count, size_t size);
+void AllocateBoard(Game *game, size_t rows, size_t columns);
+void FreeBoard(Game *game);
+size_t TileIndex(Game *game, Position position);
+
+void InitTileGrid(Game *game);
+void MarkTileDirty(Game *game, Position position);
+void UpdateTileState(Game *game, uint32_t tile);
+
+size_t SnakeCapacityFor(size_t length);
+Position *SnakeTile(Snake *snake, size_t i);
+void SnakeAdvance(Game *game, Snake *snake, Position position);
+void SnakePushTail(Game *game, Snake *snake, Position position);
+void SnakePopTail(Game *game, Snake *snake);
+void FreeSnake(Snake *snake);
+void InitSnake(Game *game, Snake *snake, TileState value, size_t row, size_t column, size_t length);
+
+void InitPlayerPath(PlayerPath *path, Position start);
+void PlayerPathPush(PlayerPath *path, Direction dir);
+Direction PlayerPathDirection(PlayerPath *path, size_t idx);
+void FreePlayerPath(PlayerPath *path);
+
+void InitFreeTiles(Game *game);
+bool PlaceFoodRandomly(Game *game, Food *food);
+void InitFood(Game *game, Food *food);
+
+void InitGame(Game *game, size_t rows, size_t columns, uint64_t seed);
+void ResetGame(Game *game);
+void ClearGame(Game *game);
+void FreeGame(Game *game);
+void RestartGame(Game *game);
+
+void GameMarkTiles(Game *game);
+
+Position MovePosition(Game *game, Position position, Direction dir);
+void SnakeDoStep(Game *game, Snake *snake);
+void HandleDirectionInput(Direction dir, Direction *next_dir, Direction *next_next_dir, bool *has_next_next_dir, unsigned input);
+void SnakeHandleInput(Snake *snake, unsigned input);
+void SnakeGrow(Game *game, Snake *snake);
+void SpawnClone(Game *game, Snake *player);
+void MoveClones(Game *game);
+void ReduceClones(Game *game);
+bool CheckForCollisions(Game *game, Snake *player);
+bool GameEatFood(Game *game);
+
+unsigned GameStep(Game *game);
+
+#endif
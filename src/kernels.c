@@ -0,0 +1,117 @@
+#include "kernels.h"
+#include "stb_ds.h"
+
+// Brings a coordinate that stepped one tile off the board back onto it
+#define WRAP_ANY(value, size) ((value) + ((value) < 0) * (size) - ((value) >= (size)) * (size))
+#define WRAP_POW2(value, size) ((value) & ((size) - 1))
+
+// A ROWS or COLUMNS of 0 reads the size from the game or batch at run time;
+// anything else is a compile time constant the compiler folds into WRAP.
+#define DEFINE_BOARD_KERNELS(NAME, TABLE, LABEL, ROWS, COLUMNS, WRAP) \
+    Position MovePosition##NAME(Game *game, Position position, Direction dir) { \
+        int rows = ROWS ? ROWS : (int)game->rows; \
+        int columns = COLUMNS ? COLUMNS : (int)game->columns; \
+        int row = position.row + (dir == DOWN_DIRECTION) - (dir == UP_DIRECTION); \
+        int column = position.column + (dir == RIGHT_DIRECTION) - (dir == LEFT_DIRECTION); \
+        return (Position) { \
+            .row = WRAP(row, rows), \
+            .column = WRAP(column, columns) \
+        }; \
+    } \
+    \
+    void MoveClones##NAME(Game *game) { \
+        size_t clones_len = arrlen(game->clones); \
+        size_t player_path_len = game->player_path.length; \
+        for (size_t i = 0; i < clones_len; i++) { \
+            SnakeClone *clone = &game->clones[i]; \
+            if (clone->player_path_idx >= player_path_len) { \
+                continue; \
+            } \
+            /* A clone's head always sits on player_path[player_path_idx - 1] */ \
+            Position next = game->player_path.start; \
+            if (clone->player_path_idx > 0) { \
+                Direction dir = PlayerPathDirection(&game->player_path, clone->player_path_idx); \
+                next = MovePosition##NAME(game, *SnakeTile(&clone->snake, 0), dir); \
+            } \
+            SnakeAdvance(game, &clone->snake, next); \
+            clone->player_path_idx++; \
+        } \
+    } \
+    \
+    /* Same as SnakeDoStep's direction and head update, written without branches */ \
+    void GameBatchAdvanceHeads##NAME(GameBatch *batch) { \
+        size_t count = batch->count; \
+        int board_rows = ROWS ? ROWS : (int)batch->rows; \
+        int board_columns = COLUMNS ? COLUMNS : (int)batch->columns; \
+        int *restrict rows = batch->head_rows; \
+        int *restrict columns = batch->head_columns; \
+        Direction *restrict dirs = batch->dirs; \
+        Direction *restrict next_dirs = batch->next_dirs; \
+        const Direction *restrict next_next_dirs = batch->next_next_dirs; \
+        bool *restrict has_next_next_dirs = batch->has_next_next_dirs; \
+        const int *restrict food_rows = batch->food_rows; \
+        const int *restrict food_columns = batch->food_columns; \
+        const bool *restrict game_over = batch->game_over; \
+        bool *restrict eaten = batch->eaten; \
+        \
+        for (size_t i = 0; i < count; i++) { \
+            bool alive = !game_over[i]; \
+            Direction dir = alive ? next_dirs[i] : dirs[i]; \
+            \
+            int row = rows[i] + (dir == DOWN_DIRECTION) - (dir == UP_DIRECTION); \
+            int column = columns[i] + (dir == RIGHT_DIRECTION) - (dir == LEFT_DIRECTION); \
+            row = WRAP(row, board_rows); \
+            column = WRAP(column, board_columns); \
+            \
+            bool promote = alive && has_next_next_dirs[i]; \
+            dirs[i] = dir; \
+            next_dirs[i] = promote ? next_next_dirs[i] : next_dirs[i]; \
+            has_next_next_dirs[i] = has_next_next_dirs[i] && !promote; \
+            \
+            rows[i] = alive ? row : rows[i]; \
+            columns[i] = alive ? column : columns[i]; \
+            eaten[i] = alive && row == food_rows[i] && column == food_columns[i]; \
+        } \
+    } \
+    \
+    const BoardKernels TABLE##_BOARD_KERNELS = { \
+        .name = LABEL, \
+        .rows = ROWS, \
+        .columns = COLUMNS, \
+        .move_position = MovePosition##NAME, \
+        .move_clones = MoveClones##NAME, \
+        .advance_heads = GameBatchAdvanceHeads##NAME \
+    };
+
+DEFINE_BOARD_KERNELS(Generic, GENERIC, "generic", 0, 0, WRAP_ANY)
+DEFINE_BOARD_KERNELS(Pow2, POW2, "pow2", 0, 0, WRAP_POW2)
+DEFINE_BOARD_KERNELS(Classic, CLASSIC, "28x52", DEFAULT_ROWS, DEFAULT_COLUMNS, WRAP_ANY)
+DEFINE_BOARD_KERNELS(Square32, SQUARE_32, "32x32", 32, 32, WRAP_POW2)
+DEFINE_BOARD_KERNELS(Square64, SQUARE_64, "64x64", 64, 64, WRAP_POW2)
+DEFINE_BOARD_KERNELS(Square128, SQUARE_128, "128x128", 128, 128, WRAP_POW2)
+DEFINE_BOARD_KERNELS(Square256, SQUARE_256, "256x256", 256, 256, WRAP_POW2)
+DEFINE_BOARD_KERNELS(Square512, SQUARE_512, "512x512", 512, 512, WRAP_POW2)
+DEFINE_BOARD_KERNELS(Square1024, SQUARE_1024, "1024x1024", 1024, 1024, WRAP_POW2)
+
+const BoardKernels *SPECIALIZED_BOARD_KERNELS[] = {
+    &CLASSIC_BOARD_KERNELS,
+    &SQUARE_32_BOARD_KERNELS,
+    &SQUARE_64_BOARD_KERNELS,
+    &SQUARE_128_BOARD_KERNELS,
+    &SQUARE_256_BOARD_KERNELS,
+    &SQUARE_512_BOARD_KERNELS,
+    &SQUARE_1024_BOARD_KERNELS
+};
+
+const BoardKernels *SelectBoardKernels(size_t rows, size_t columns) {
+    size_t count = sizeof(SPECIALIZED_BOARD_KERNELS) / sizeof(SPECIALIZED_BOARD_KERNELS[0]);
+    for (size_t i = 0; i < count; i++) {
+        const BoardKernels *kernels = SPECIALIZED_BOARD_KERNELS[i];
+        if (kernels->rows == rows && kernels->columns == columns) {
+            return kernels;
+        }
+    }
+
+    bool is_pow2 = (rows & (rows - 1)) == 0 && (columns & (columns - 1)) == 0;
+    return is_pow2 ? &POW2_BOARD_KERNELS : &GENERIC_BOARD_KERNELS;
+}
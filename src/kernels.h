@@ -0,0 +1,24 @@
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include "batch.h"
+
+// The loops whose cost depends on the board size, compiled once per
+// supported size so the wrap-around folds into constants (or into a mask
+// on power of two boards). AllocateBoard picks a set for each game with
+// SelectBoardKernels, falling back to GENERIC_BOARD_KERNELS.
+struct BoardKernels {
+    const char *name;
+    size_t rows;    // 0 when the kernels take the size from the game
+    size_t columns;
+    Position (*move_position)(Game *game, Position position, Direction dir);
+    void (*move_clones)(Game *game);
+    void (*advance_heads)(GameBatch *batch);
+};
+
+extern const BoardKernels GENERIC_BOARD_KERNELS;
+extern const BoardKernels POW2_BOARD_KERNELS;
+
+const BoardKernels *SelectBoardKernels(size_t rows, size_t columns);
+
+#endif
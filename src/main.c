@@ -5,13 +5,23 @@
 #include <raymath.h>
 #include <rlgl.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
-#include "stb_ds.h"
+#include "animate.h"
+#include "bot.h"
+#include "game.h"
+#include "post.h"
+#include "profiler.h"
+#include "replay.h"
+#include "timeline.h"
 
 #define SCORE_ANIMATION_DURATION 0.3
 
 #define STEP_INTERVAL 0.1
+#define MAX_STEPS_PER_FRAME 5
+// Scrubbing speed while rewinding, ten times this with shift held
+#define REWIND_STEPS_PER_SECOND 20
 #define SCALE 0.75
 
 #define BASE_WIDTH 1920
@@ -23,16 +33,27 @@
 #define GAME_WIDTH ((int)(BASE_WIDTH / 2)) // 960
 #define GAME_HEIGHT ((int)(BASE_HEIGHT / 2))
 
-#define ROWS 28
-#define COLUMNS 52
-#define TILE_SIZE 16
-#define TILE_SPACING 2
-
 #define GRID_OFFSET_X 12
 #define GRID_OFFSET_Y 35
 
+// The post benchmark plays this many bot steps to get a busy board, then
+// renders every frame as if POST_BENCH_DT had passed
+#define POST_BENCH_STEPS 400
+#define POST_BENCH_DT (1.0 / 60)
+
 Font arcadeFont;
 
+// Where the grid sits on the game texture. Tiles keep their usual size and
+// spacing unless the board is too big for them, then shrink to fit.
+typedef struct {
+    float x;
+    float y;
+    float tile_size;
+    float tile_spacing;
+} GridLayout;
+
+GridLayout gridLayout;
+
 typedef struct {
     float scale;
     float angle;
@@ -51,121 +72,39 @@ typedef struct {
 } ShakeEffect;
 
 typedef enum {
-    EMPTY_TILE,
-    VISITED_TILE,
-    PLAYER_TILE,
-    FOOD_TILE,
-    CLONE_TILE,
-    CLONE_AND_PLAYER_TILE
-} TileState;
-
-typedef struct {
-    float timer;
-    float angle;
-    TileState state;
-    bool visited;
-} Tile;
-
-typedef struct {
-    int row;
-    int column;
-} Position;
-
-typedef enum {
-    UP_DIRECTION,
-    DOWN_DIRECTION,
-    LEFT_DIRECTION,
-    RIGHT_DIRECTION
-} Direction;
-
+    TILE_RENDER_IMMEDIATE,
+    TILE_RENDER_BATCHED,
+    TILE_RENDER_GPU,
+    TILE_RENDER_COUNT
+} TileRenderer;
+
+// Draws the grid as a single quad: the tile shader looks up its cell in a
+// one-texel-per-tile state texture and does the rotation, sizing and
+// coloring itself. The state and timer arrays of the TileGrid are uploaded
+// as they are, one texture each; states only where they changed.
 typedef struct {
-    Position *tiles;
-    TileState value;
-    Direction dir;
-    Direction next_dir;
-    Direction next_next_dir;
-    bool has_next_next_dir;
-} Snake;
-
-typedef struct {
-    Snake snake;
-    size_t player_path_idx;
-} SnakeClone;
-
-typedef struct {
-    Position position;
-    TileState value;
-} Food;
-
-typedef struct {
-    bool game_over;
-    Tile tileGrid[ROWS][COLUMNS];
-    Snake player;
-    Food food;
-    Position *player_path;
-    SnakeClone *clones;
-} Game;
+    Shader shader;
+    Texture2D states;
+    Texture2D timers;
+    int timersLoc;
+    int foodLoc;
+    // Set when the renderer comes back into use: the states changed while
+    // another renderer drew, so the next frame sends them all
+    bool needs_full_upload;
+} TileGpuRenderer;
 
 Game game;
 
-void InitTileGrid(void) {
-    for (size_t row = 0; row < ROWS; row++) {
-        for (size_t column = 0; column < COLUMNS; column++) {
-            Tile *tile = &game.tileGrid[row][column];
-            tile->state = EMPTY_TILE;
-            tile->angle = 0;
-            tile->timer = (row + 1) * (TILE_SIZE + TILE_SPACING) * (column + 1) * (TILE_SIZE + TILE_SPACING);
-            tile->visited = false;
-        }
-    }
-}
-
-void InitSnake(Snake *snake, TileState value, size_t row, size_t column, size_t length, bool is_player) {
-    snake->tiles = nullptr;
-    snake->value = value;
-    snake->dir = RIGHT_DIRECTION;
-    snake->next_dir = RIGHT_DIRECTION;
-    snake->next_next_dir = RIGHT_DIRECTION;
-    snake->has_next_next_dir = false;
-
-    Position start_position = (Position) {
-        .row = row,
-        .column = column
+GridLayout GetGridLayout(size_t rows, size_t columns) {
+    float pitch = TILE_SIZE + TILE_SPACING;
+    pitch = fminf(pitch, (GAME_WIDTH - 2 * GRID_OFFSET_X) / (float)columns);
+    pitch = fminf(pitch, (GAME_HEIGHT - GRID_OFFSET_Y) / (float)rows);
+    return (GridLayout) {
+        .x = GRID_OFFSET_X,
+        .y = GRID_OFFSET_Y,
+        .tile_size = pitch * TILE_SIZE / (TILE_SIZE + TILE_SPACING),
+        .tile_spacing = pitch * TILE_SPACING / (TILE_SIZE + TILE_SPACING)
     };
-
-    for (size_t i = 0; i < length; i++) {
-        arrpush(snake->tiles, start_position);
-    }
-
-    if (is_player) {
-        arrpush(game.player_path, start_position);
-    }
-}
-
-void PlaceFoodRandomly(Food *food) {
-    size_t row, column;
-    do {
-        row = rand() % ROWS;
-        column = rand() % COLUMNS;
-    } while (game.tileGrid[row][column].state != EMPTY_TILE && game.tileGrid[row][column].state != VISITED_TILE);
-
-    food->position.row = row;
-    food->position.column = column;
-}
-
-void InitFood(Food *food) {
-    food->value = FOOD_TILE;
-    PlaceFoodRandomly(food);
-}
-
-void InitGame(void) {
-    game.player_path = nullptr;
-    game.clones = nullptr;
-    game.game_over = false;
-
-    InitTileGrid();
-    InitSnake(&game.player, PLAYER_TILE, 13, 24, 3, true);
-    InitFood(&game.food);
 }
 
 Color GetTileColor(TileState state) {
@@ -185,38 +124,45 @@ Color GetTileColor(TileState state) {
     }
 }
 
+Color GetTileDrawColor(TileState state, size_t row, size_t column) {
+    Color color = GetTileColor(state);
+    if (game.food.position.row - row == 0 || game.food.position.column - column == 0) {
+        color.r = Clamp(color.r + 10, 0, 255);
+        color.g = Clamp(color.g + 10, 0, 255);
+        color.b = Clamp(color.b + 10, 0, 255);
+    }
+    return Fade(color, game.game_over ? 0.7 : 1.0);
+}
+
 void DrawTileGrid(void) {
-    for (size_t row = 0; row < ROWS; row++) {
-        for (size_t column = 0; column < COLUMNS; column++) {
-            Tile *tile = &game.tileGrid[row][column];
+    float tile_size = gridLayout.tile_size;
+    float tile_spacing = gridLayout.tile_spacing;
+    for (size_t row = 0; row < game.rows; row++) {
+        for (size_t column = 0; column < game.columns; column++) {
+            size_t tile = row * game.columns + column;
+            TileState state = game.tileGrid.states[tile];
 
-            float drawX = column * (TILE_SIZE + TILE_SPACING) + GRID_OFFSET_X;
-            float drawY = row * (TILE_SIZE + TILE_SPACING) + GRID_OFFSET_Y;
+            float drawX = column * (tile_size + tile_spacing) + gridLayout.x;
+            float drawY = row * (tile_size + tile_spacing) + gridLayout.y;
 
             Vector2 position = (Vector2) {
-                .x = drawX + TILE_SPACING / 2.0 + (tile->state == EMPTY_TILE ? TILE_SIZE / 4.0 : 0),
-                .y = drawY + TILE_SPACING / 2.0 + (tile->state == EMPTY_TILE ? TILE_SIZE / 4.0 : 0),
+                .x = drawX + tile_spacing / 2.0 + (state == EMPTY_TILE ? tile_size / 4.0 : 0),
+                .y = drawY + tile_spacing / 2.0 + (state == EMPTY_TILE ? tile_size / 4.0 : 0),
             };
             Vector2 size = (Vector2) {
-                .x = tile->state == EMPTY_TILE ? TILE_SIZE / 2.0 : TILE_SIZE,
-                .y = tile->state == EMPTY_TILE ? TILE_SIZE / 2.0 : TILE_SIZE,
+                .x = state == EMPTY_TILE ? tile_size / 2.0 : tile_size,
+                .y = state == EMPTY_TILE ? tile_size / 2.0 : tile_size,
             };
-            Color color = GetTileColor(tile->state);
-            if (game.food.position.row - row == 0 || game.food.position.column - column == 0) {
-                color.r = Clamp(color.r + 10, 0, 255);
-                color.g = Clamp(color.g + 10, 0, 255);
-                color.b = Clamp(color.b + 10, 0, 255);
-            }
-            color = Fade(color, game.game_over ? 0.7 : 1.0);
+            Color color = GetTileDrawColor(state, row, column);
 
             Vector2 center = (Vector2) {
-                .x = drawX + TILE_SPACING / 2.0 + TILE_SIZE / 2.0,
-                .y = drawY + TILE_SPACING / 2.0 + TILE_SIZE / 2.0,
+                .x = drawX + tile_spacing / 2.0 + tile_size / 2.0,
+                .y = drawY + tile_spacing / 2.0 + tile_size / 2.0,
             };
 
             rlPushMatrix();
             rlTranslatef(center.x, center.y, 0);
-            rlRotatef(tile->state == EMPTY_TILE ? (RAD2DEG * tile->angle) : 0, 0, 0, 1);
+            rlRotatef(state == EMPTY_TILE ? (RAD2DEG * game.tileGrid.angles[tile]) : 0, 0, 0, 1);
             rlTranslatef(-center.x, -center.y, 0);
             DrawRectangleV(position, size, color);
             rlPopMatrix();
@@ -224,210 +170,156 @@ void DrawTileGrid(void) {
     }
 }
 
-void UpdateTileGrid(float dt) {
-    for (size_t row = 0; row < ROWS; row++) {
-        for (size_t column = 0; column < COLUMNS; column++) {
-            Tile *tile = &game.tileGrid[row][column];
-            tile->timer += dt;
-            tile->angle = sinf(tile->timer) * PI;
-            tile->state = tile->visited ? VISITED_TILE : EMPTY_TILE;
-        }
-    }
-}
-
-void SnakeMarkTiles(Snake *snake) {
-    size_t len = arrlen(snake->tiles);
-    for (size_t i = 0; i < len; i++) {
-        Position *p = &snake->tiles[i];
-        Tile *tile = &game.tileGrid[p->row][p->column];
-        tile->visited = true;
-
-        bool is_player_tile = tile->state == PLAYER_TILE || tile->state == CLONE_AND_PLAYER_TILE;
-        bool is_clone_tile = tile->state == CLONE_TILE || tile->state == CLONE_AND_PLAYER_TILE;
-
-        if ((is_player_tile && snake->value == CLONE_TILE) || (is_clone_tile && snake->value == PLAYER_TILE)) {
-            tile->state = CLONE_AND_PLAYER_TILE;
-        } else {
-            tile->state = snake->value;
-        }
-    }
-}
-
-void SnakeDoStep(Snake *snake) {
-    snake->dir = snake->next_dir;
-
-    int dx = 0, dy = 0;
-    if (snake->dir == UP_DIRECTION) dy = -1;
-    else if (snake->dir == DOWN_DIRECTION) dy = 1;
-    else if (snake->dir == LEFT_DIRECTION) dx = -1;
-    else if (snake->dir == RIGHT_DIRECTION) dx = 1;
-
-    Position *head = &snake->tiles[0];
-    Position new_head = (Position) {
-        .row = head->row + dy,
-        .column = head->column + dx
+// Same picture as DrawTileGrid, but every tile quad is rotated on the CPU
+// and emitted into a single rlgl batch, so the whole grid is one draw call
+// instead of a matrix push/pop and transform per tile.
+void DrawTileGridBatched(void) {
+    Texture2D texture = GetShapesTexture();
+    Rectangle source = GetShapesTextureRectangle();
+    Vector2 uv_min = (Vector2) {
+        .x = source.x / texture.width,
+        .y = source.y / texture.height
+    };
+    Vector2 uv_max = (Vector2) {
+        .x = (source.x + source.width) / texture.width,
+        .y = (source.y + source.height) / texture.height
     };
 
-    if (new_head.row < 0) {
-        new_head.row = ROWS - 1;
-    } else if (new_head.row >= ROWS) {
-        new_head.row = 0;
-    } else if (new_head.column < 0) {
-        new_head.column = COLUMNS - 1;
-    } else if (new_head.column >= COLUMNS) {
-        new_head.column = 0;
-    }
-
-    size_t len = arrlen(snake->tiles);
-    for (size_t i = len - 1; i > 0; i--) {
-        snake->tiles[i] = snake->tiles[i-1];
-    }
-    snake->tiles[0] = new_head;
-    arrpush(game.player_path, new_head);
-
-    if (snake->has_next_next_dir) {
-        snake->next_dir = snake->next_next_dir;
-        snake->has_next_next_dir = false;
-    }
-}
-
-void SnakeHandleInput(Snake *snake) {
-    if (snake->dir == snake->next_dir) {
-        if (IsKeyPressed(KEY_LEFT) && snake->dir != RIGHT_DIRECTION) {
-            snake->next_dir = LEFT_DIRECTION;
-        }
-        if (IsKeyPressed(KEY_RIGHT) && snake->dir != LEFT_DIRECTION) {
-            snake->next_dir = RIGHT_DIRECTION;
-        }
-        if (IsKeyPressed(KEY_UP) && snake->dir != DOWN_DIRECTION) {
-            snake->next_dir = UP_DIRECTION;
-        }
-        if (IsKeyPressed(KEY_DOWN) && snake->dir != UP_DIRECTION) {
-            snake->next_dir = DOWN_DIRECTION;
-        }
-    } else {
-        if (IsKeyPressed(KEY_LEFT) && snake->next_dir != RIGHT_DIRECTION) {
-            snake->has_next_next_dir = true;
-            snake->next_next_dir = LEFT_DIRECTION;
-        }
-        if (IsKeyPressed(KEY_RIGHT) && snake->next_dir != LEFT_DIRECTION) {
-            snake->has_next_next_dir = true;
-            snake->next_next_dir = RIGHT_DIRECTION;
-        }
-        if (IsKeyPressed(KEY_UP) && snake->next_dir != DOWN_DIRECTION) {
-            snake->has_next_next_dir = true;
-            snake->next_next_dir = UP_DIRECTION;
-        }
-        if (IsKeyPressed(KEY_DOWN) && snake->next_dir != UP_DIRECTION) {
-            snake->has_next_next_dir = true;
-            snake->next_next_dir = DOWN_DIRECTION;
+    float tile_size = gridLayout.tile_size;
+    float tile_spacing = gridLayout.tile_spacing;
+
+    // Large boards do not fit in one rlgl batch, so make room a row at a
+    // time; consecutive rows still go out as a single draw call
+    rlSetTexture(texture.id);
+    for (size_t row = 0; row < game.rows; row++) {
+        rlCheckRenderBatchLimit(game.columns * 4);
+        rlBegin(RL_QUADS);
+        for (size_t column = 0; column < game.columns; column++) {
+            size_t tile = row * game.columns + column;
+            TileState state = game.tileGrid.states[tile];
+            bool is_empty = state == EMPTY_TILE;
+
+            float centerX = column * (tile_size + tile_spacing) + gridLayout.x + tile_spacing / 2.0 + tile_size / 2.0;
+            float centerY = row * (tile_size + tile_spacing) + gridLayout.y + tile_spacing / 2.0 + tile_size / 2.0;
+            float half = is_empty ? tile_size / 4.0 : tile_size / 2.0;
+
+            // Corner offsets (-half, -half) and (-half, half) rotated; the
+            // other two corners are their mirror images through the center
+            float cosine = is_empty ? cosf(game.tileGrid.angles[tile]) : 1;
+            float sine = is_empty ? sinf(game.tileGrid.angles[tile]) : 0;
+            float ax = half * (sine - cosine), ay = -half * (sine + cosine);
+            float bx = -half * (sine + cosine), by = half * (cosine - sine);
+
+            Color color = GetTileDrawColor(state, row, column);
+            rlColor4ub(color.r, color.g, color.b, color.a);
+            rlNormal3f(0, 0, 1);
+
+            rlTexCoord2f(uv_min.x, uv_min.y);
+            rlVertex2f(centerX + ax, centerY + ay);
+            rlTexCoord2f(uv_min.x, uv_max.y);
+            rlVertex2f(centerX + bx, centerY + by);
+            rlTexCoord2f(uv_max.x, uv_max.y);
+            rlVertex2f(centerX - ax, centerY - ay);
+            rlTexCoord2f(uv_max.x, uv_min.y);
+            rlVertex2f(centerX - bx, centerY - by);
         }
+        rlEnd();
     }
+    rlSetTexture(0);
 }
 
-void FoodMarkTile(Food *food) {
-    Tile *tile = &game.tileGrid[food->position.row][food->position.column];
-    tile->state = food->value;
-}
-
-void SnakeGrow(Snake *snake) {
-    size_t len = arrlen(snake->tiles);
-    Position last = snake->tiles[len-1];
-    arrpush(snake->tiles, last);
-}
-
-void SpawnClone(Snake *player) {
-    Snake snake;
-    size_t row = game.player_path[0].row;
-    size_t column = game.player_path[0].column;
-    size_t length = arrlen(player->tiles);
-    InitSnake(&snake, CLONE_TILE, row, column, length, false);
-
-    SnakeClone clone = (SnakeClone) {
-        .snake = snake,
-        .player_path_idx = 0
-    };
-
-    arrpush(game.clones, clone);
-}
-
-void ClonesMarkTiles() {
-    size_t clones_len = arrlen(game.clones);
-    for (size_t i = 0; i < clones_len; i++) {
-        SnakeMarkTiles(&game.clones[i].snake);
+bool LoadTileGpuRenderer(TileGpuRenderer *renderer) {
+    renderer->shader = LoadShader(0, "assets/shaders/tiles.glsl");
+    if (renderer->shader.id == rlGetShaderIdDefault()) {
+        return false;
     }
+    renderer->timersLoc = GetShaderLocation(renderer->shader, "timers");
+    renderer->foodLoc = GetShaderLocation(renderer->shader, "food");
+    SetShaderValue(renderer->shader, GetShaderLocation(renderer->shader, "gridSize"), &(Vector2) {game.columns, game.rows}, SHADER_UNIFORM_VEC2);
+    SetShaderValue(renderer->shader, GetShaderLocation(renderer->shader, "tileSize"), &gridLayout.tile_size, SHADER_UNIFORM_FLOAT);
+    SetShaderValue(renderer->shader, GetShaderLocation(renderer->shader, "tileSpacing"), &gridLayout.tile_spacing, SHADER_UNIFORM_FLOAT);
+
+    renderer->states = LoadTextureFromImage((Image) {
+        .data = game.tileGrid.states,
+        .width = game.columns,
+        .height = game.rows,
+        .mipmaps = 1,
+        .format = PIXELFORMAT_UNCOMPRESSED_GRAYSCALE
+    });
+    renderer->timers = LoadTextureFromImage((Image) {
+        .data = game.tileGrid.timers,
+        .width = game.columns,
+        .height = game.rows,
+        .mipmaps = 1,
+        .format = PIXELFORMAT_UNCOMPRESSED_R32
+    });
+    SetTextureFilter(renderer->states, TEXTURE_FILTER_POINT);
+    SetTextureFilter(renderer->timers, TEXTURE_FILTER_POINT);
+    return true;
 }
 
-void MoveClones() {
-    size_t clones_len = arrlen(game.clones);
-    size_t player_path_len = arrlen(game.player_path);
-    for (size_t i = 0; i < clones_len; i++) {
-        SnakeClone *clone = &game.clones[i];
-
-        if (clone->player_path_idx >= player_path_len) {
-            continue;
-        }
-
-        Position next = game.player_path[clone->player_path_idx];
-        size_t len = arrlen(clone->snake.tiles);
-        for (size_t j = len - 1; j > 0; j--) {
-            clone->snake.tiles[j] = clone->snake.tiles[j-1];
-        }
-        clone->snake.tiles[0] = next;
-        clone->player_path_idx++;
-    }
-}
-
-void ReduceClones(void) {
-    size_t clones_len = arrlen(game.clones);
-    for (int i = clones_len - 1; i >= 0; i--) {
-        SnakeClone *clone = &game.clones[i];
-
-        arrpop(clone->snake.tiles);
-
-        if (arrlen(clone->snake.tiles) == 0) {
-            arrdelswap(game.clones, i);
-        }
-    }
+void UnloadTileGpuRenderer(TileGpuRenderer *renderer) {
+    UnloadTexture(renderer->states);
+    UnloadTexture(renderer->timers);
+    UnloadShader(renderer->shader);
 }
 
-bool CheckForCollisions(Snake *player) {
-    Position *head = &player->tiles[0];
-    size_t len = arrlen(player->tiles);
-    for (size_t i = 1; i < len; i++) {
-        Position *p = &player->tiles[i];
-        if (p->row == head->row && p->column == head->column) {
-            return true;
+void DrawTileGridGpu(TileGpuRenderer *renderer) {
+    // Only the tiles GameMarkTiles touched need new states; past a row's
+    // worth it is cheaper to send the whole texture in one go
+    TileGrid *grid = &game.tileGrid;
+    if (renderer->needs_full_upload || grid->updated_count > game.columns) {
+        UpdateTexture(renderer->states, grid->states);
+        renderer->needs_full_upload = false;
+    } else {
+        for (size_t i = 0; i < grid->updated_count; i++) {
+            uint32_t tile = grid->updated_tiles[i];
+            Rectangle cell = (Rectangle) {
+                .x = tile % game.columns,
+                .y = tile / game.columns,
+                .width = 1,
+                .height = 1
+            };
+            UpdateTextureRec(renderer->states, cell, &grid->states[tile]);
         }
     }
+    UpdateTexture(renderer->timers, grid->timers);
 
-    size_t clones_len = arrlen(game.clones);
-    for (size_t i = 0; i < clones_len; i++) {
-        SnakeClone *clone = &game.clones[i];
-        len = arrlen(clone->snake.tiles);
-        for (size_t j = 0; j < len; j++) {
-            Position *p = &clone->snake.tiles[j];
-            if (p->row == head->row && p->column == head->column) {
-                return true;
-            }
-        }
-    }
+    Vector2 food = (Vector2) {
+        .x = game.food.position.column,
+        .y = game.food.position.row
+    };
 
-    return false;
+    BeginShaderMode(renderer->shader);
+        SetShaderValue(renderer->shader, renderer->foodLoc, &food, SHADER_UNIFORM_VEC2);
+        SetShaderValueTexture(renderer->shader, renderer->timersLoc, renderer->timers);
+        DrawTexturePro(
+            renderer->states,
+            (Rectangle) {0, 0, game.columns, game.rows},
+            (Rectangle) {
+                .x = gridLayout.x,
+                .y = gridLayout.y,
+                .width = game.columns * (gridLayout.tile_size + gridLayout.tile_spacing),
+                .height = game.rows * (gridLayout.tile_size + gridLayout.tile_spacing)
+            },
+            (Vector2) {0},
+            0,
+            Fade(WHITE, game.game_over ? 0.7 : 1.0)
+        );
+    EndShaderMode();
 }
 
-void RestartGame(void) {
-    if (game.player_path) {
-        arrfree(game.player_path);
-    }
-    if (game.clones) {
-        arrfree(game.clones);
+// Only the CPU renderers need the angles; the tile shader derives them
+void UpdateTileGrid(float dt, bool needs_angles) {
+    if (needs_angles) {
+        AnimateTiles(game.tileGrid.timers, game.tileGrid.angles, game.rows * game.columns, dt);
+    } else {
+        AdvanceTileTimers(game.tileGrid.timers, game.rows * game.columns, dt);
     }
-    InitGame();
 }
 
 void DrawGameOver(void) {
-    const char *game_over_text = "GAME OVER";
+    const char *game_over_text = game.board_full ? "BOARD FULL" : "GAME OVER";
     size_t game_over_font_size = 70;
     Vector2 game_over_size = MeasureTextEx(arcadeFont, game_over_text, game_over_font_size, 0);
     DrawTextEx(
@@ -458,6 +350,42 @@ void DrawGameOver(void) {
     );
 }
 
+void DrawRewind(Timeline *timeline) {
+    const char *rewind_text = "REWIND";
+    size_t rewind_font_size = 70;
+    Vector2 rewind_size = MeasureTextEx(arcadeFont, rewind_text, rewind_font_size, 0);
+    DrawTextEx(
+        arcadeFont,
+        rewind_text,
+        (Vector2) {
+            .x = (GAME_WIDTH - rewind_size.x) / 2.0,
+            .y = (GAME_HEIGHT - rewind_size.y) / 3.0
+        },
+        rewind_font_size,
+        0,
+        WHITE
+    );
+
+    const char *step_text = TextFormat(
+        "STEP %llu OF %llu",
+        (unsigned long long)timeline->cursor,
+        (unsigned long long)timeline->step
+    );
+    size_t step_font_size = 24;
+    Vector2 step_size = MeasureTextEx(arcadeFont, step_text, step_font_size, 0);
+    DrawTextEx(
+        arcadeFont,
+        step_text,
+        (Vector2) {
+            .x = (GAME_WIDTH - step_size.x) / 2.0,
+            .y = (GAME_HEIGHT - step_size.y) * 2 / 3.0
+        },
+        step_font_size,
+        0,
+        WHITE
+    );
+}
+
 void UpdateScaleEffect(ScaleEffect *effect, float dt) {
     if (effect->scale != effect->target_scale) {
         effect->scale -= (effect->scale - effect->target_scale) * dt * effect->speed;
@@ -479,7 +407,7 @@ void UpdateShakeEffect(ShakeEffect *effect, float dt) {
 void DrawScore(ScoreEffect *effect) {
     char score_text[32];
     size_t score_text_font_size = 32;
-    size_t score = arrlen(game.player.tiles);
+    size_t score = game.player.length;
     snprintf(score_text, sizeof(score_text), "LENGTH: %zu", score);
 
     Vector2 score_text_size = MeasureTextEx(arcadeFont, score_text, score_text_font_size, 0);
@@ -519,24 +447,198 @@ void UpdateScoreEffect(ScoreEffect *effect, float dt) {
     }
 }
 
-int main(void) {
-    srand(time(nullptr));
+int CompareDoubles(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Renders the board as it stands through the tile renderer and the post
+// chain, uncapped and without input, and prints the frame times and the
+// profiler's GPU pass times. The last frame goes to png_path when given.
+// The final pass draws into a render texture, so the hidden window's
+// framebuffer is never read.
+int RunPostBenchmark(PostChain *post, Profiler *profiler, RenderTexture2D target, TileGpuRenderer *renderer, bool has_gpu_renderer, int frames, const char *png_path) {
+    RenderTexture2D output = LoadRenderTexture(GAME_WIDTH, GAME_HEIGHT);
+    double *frame_times = malloc(sizeof(double) * frames);
+    ScoreEffect score_effect = (ScoreEffect) { .scale = 1.0 };
+    profiler->visible = true;
+
+    // Bring the states up to date with the bot's game and send them to the
+    // GPU renderer whole, outside the timed frames
+    GameMarkTiles(&game);
+    if (has_gpu_renderer) {
+        UpdateTexture(renderer->states, game.tileGrid.states);
+    }
+
+    for (int frame = 0; frame < frames; frame++) {
+        double start = GetTime();
+        float time = frame * POST_BENCH_DT;
+        UpdateTileGrid(POST_BENCH_DT, !has_gpu_renderer);
+        // Nothing steps, so this finds no changed tiles, as on a frame
+        // between steps
+        GameMarkTiles(&game);
+
+        BeginProfileStage(profiler, PROFILE_FRAME);
+        BeginDrawing();
+            BeginGpuProfile(profiler);
+            BeginTextureMode(target);
+                ClearBackground(BLACK);
+                if (has_gpu_renderer) {
+                    DrawTileGridGpu(renderer);
+                } else {
+                    DrawTileGridBatched();
+                }
+                DrawScore(&score_effect);
+            EndTextureMode();
+            MarkGpuProfile(profiler, "scene");
+
+            RunPostChain(post, target.texture, time);
+            BeginTextureMode(output);
+                DrawPostChain(post, target.texture, (Rectangle) {0, 0, GAME_WIDTH, GAME_HEIGHT}, time);
+            EndTextureMode();
+            MarkGpuProfile(profiler, "screen");
+            EndGpuProfile(profiler);
+        EndDrawing();
+        EndProfileStage(profiler, PROFILE_FRAME);
+
+        frame_times[frame] = (GetTime() - start) * 1000;
+    }
+
+    double total = 0;
+    for (int i = 0; i < frames; i++) {
+        total += frame_times[i];
+    }
+    qsort(frame_times, frames, sizeof(double), CompareDoubles);
+    const char *bloom_modes[BLOOM_MODE_COUNT] = {"ping-pong", "mip-chain"};
+    const char *composite_modes[COMPOSITE_MODE_COUNT] = {"separate", "fused"};
+    const char *qualities[POST_QUALITY_COUNT] = {"off", "half", "full"};
+    printf("post benchmark: %d frames at %dx%d, bloom %s, composite %s, quality %s\n",
+        frames, GAME_WIDTH, GAME_HEIGHT, bloom_modes[post->bloom_mode],
+        composite_modes[post->composite_mode], qualities[post->quality]);
+    printf("frame ms: avg %.3f p50 %.3f p95 %.3f p99 %.3f max %.3f\n",
+        total / frames,
+        frame_times[(frames - 1) * 50 / 100],
+        frame_times[(frames - 1) * 95 / 100],
+        frame_times[(frames - 1) * 99 / 100],
+        frame_times[frames - 1]);
+
+    if (profiler->has_gpu_timers) {
+        printf("gpu ms over the last %d frames:%14s %8s %8s\n", PROFILE_HISTORY, "p50", "p99", "max");
+        for (int i = 0; i < profiler->gpu_series_count; i++) {
+            const ProfileSeries *series = &profiler->gpu_series[i];
+            printf("  %-40s %8.3f %8.3f %8.3f\n", profiler->gpu_labels[i],
+                ProfilePercentile(series, 50), ProfilePercentile(series, 99), ProfilePercentile(series, 100));
+        }
+    } else {
+        printf("gpu timers unavailable\n");
+    }
+
+    bool exported = true;
+    if (png_path) {
+        Image image = LoadImageFromTexture(output.texture);
+        ImageFlipVertical(&image);
+        exported = ExportImage(image, png_path);
+        UnloadImage(image);
+    }
+
+    free(frame_times);
+    UnloadRenderTexture(output);
+    return exported ? 0 : 1;
+}
+
+unsigned ReadInput(void) {
+    unsigned input = 0;
+    if (IsKeyPressed(KEY_LEFT)) input |= INPUT_LEFT;
+    if (IsKeyPressed(KEY_RIGHT)) input |= INPUT_RIGHT;
+    if (IsKeyPressed(KEY_UP)) input |= INPUT_UP;
+    if (IsKeyPressed(KEY_DOWN)) input |= INPUT_DOWN;
+    return input;
+}
+
+int main(int argc, char **argv) {
+    uint64_t seed = time(nullptr);
+    int target_fps = 60;
+    int rows = DEFAULT_ROWS;
+    int columns = DEFAULT_COLUMNS;
+    // -1 leaves the post quality to the governor
+    int quality = -1;
+    int bloom_mode = -1;
+    int composite_mode = -1;
+    // A positive frame count runs the post benchmark instead of the game
+    int bench_frames = 0;
+    const char *bench_png = nullptr;
+    const char *record_path = nullptr;
+    const char *replay_path = nullptr;
+    bool seeded = false;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--seed") == 0) {
+            seed = strtoull(argv[i + 1], nullptr, 10);
+            seeded = true;
+        } else if (strcmp(argv[i], "--fps") == 0) {
+            target_fps = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--rows") == 0) {
+            rows = Clamp(atoi(argv[i + 1]), MIN_BOARD_SIZE, MAX_BOARD_SIZE);
+        } else if (strcmp(argv[i], "--columns") == 0) {
+            columns = Clamp(atoi(argv[i + 1]), MIN_BOARD_SIZE, MAX_BOARD_SIZE);
+        } else if (strcmp(argv[i], "--quality") == 0) {
+            const char *names[POST_QUALITY_COUNT] = {"off", "half", "full"};
+            for (int q = 0; q < POST_QUALITY_COUNT; q++) {
+                if (strcmp(argv[i + 1], names[q]) == 0) quality = q;
+            }
+        } else if (strcmp(argv[i], "--bloom") == 0) {
+            const char *names[BLOOM_MODE_COUNT] = {"ping-pong", "mip-chain"};
+            for (int m = 0; m < BLOOM_MODE_COUNT; m++) {
+                if (strcmp(argv[i + 1], names[m]) == 0) bloom_mode = m;
+            }
+        } else if (strcmp(argv[i], "--composite") == 0) {
+            const char *names[COMPOSITE_MODE_COUNT] = {"separate", "fused"};
+            for (int m = 0; m < COMPOSITE_MODE_COUNT; m++) {
+                if (strcmp(argv[i + 1], names[m]) == 0) composite_mode = m;
+            }
+        } else if (strcmp(argv[i], "--bench-post") == 0) {
+            bench_frames = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--bench-png") == 0) {
+            bench_png = argv[i + 1];
+        } else if (strcmp(argv[i], "--record") == 0) {
+            record_path = argv[i + 1];
+        } else if (strcmp(argv[i], "--replay") == 0) {
+            replay_path = argv[i + 1];
+        }
+    }
+
+    // The benchmark always shows the same board, never waits on vsync or
+    // the frame cap, and keeps its window out of sight
+    if (bench_frames > 0) {
+        if (!seeded) {
+            seed = 1;
+        }
+        target_fps = 0;
+        SetConfigFlags(FLAG_WINDOW_HIDDEN);
+    }
 
     InitWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "Snake Rewind");
 
-    SetTargetFPS(60);
+    SetTargetFPS(target_fps);
 
     RenderTexture2D target = LoadRenderTexture(GAME_WIDTH, GAME_HEIGHT);
-    RenderTexture2D tmpA = LoadRenderTexture(GAME_WIDTH, GAME_HEIGHT);
-    RenderTexture2D tmpB = LoadRenderTexture(GAME_WIDTH, GAME_HEIGHT);
-    RenderTexture2D blurred = LoadRenderTexture(GAME_WIDTH, GAME_HEIGHT);
-    RenderTexture2D scanlined = LoadRenderTexture(GAME_WIDTH, GAME_HEIGHT);
-
-    Shader thresholdShader = LoadShader(0, "assets/shaders/threshold.glsl");
-    Shader blurShader = LoadShader(0, "assets/shaders/blur.glsl");
-    int blurDirectionLoc = GetShaderLocation(blurShader, "direction");
-    Shader scanlineShader = LoadShader(0, "assets/shaders/scanline.glsl");
-    int scanlineTimeLoc = GetShaderLocation(scanlineShader, "time");
+    PostChain post;
+    LoadPostChain(&post, GAME_WIDTH, GAME_HEIGHT);
+    if (bloom_mode != -1) {
+        post.bloom_mode = bloom_mode;
+    }
+    if (composite_mode != -1) {
+        post.composite_mode = composite_mode;
+    }
+    Profiler profiler;
+    InitProfiler(&profiler);
+    post.profiler = &profiler;
+    // An uncapped frame rate is still held to 60 FPS worth of budget
+    QualityGovernor governor;
+    InitQualityGovernor(&governor, 1.0 / (target_fps > 0 ? target_fps : 60));
+    if (quality != -1 || bench_frames > 0) {
+        post.quality = quality != -1 ? quality : POST_QUALITY_FULL;
+        governor.enabled = false;
+    }
 
     arcadeFont = LoadFont("assets/fonts/ARCADE_N.TTF");
 
@@ -557,151 +659,244 @@ int main(void) {
         .scale = 1.0
     };
 
-    InitGame();
+    // A replay brings its own board and seed and takes no direction keys
+    ReplayReader replay_reader;
+    bool replaying = false;
+    if (replay_path) {
+        replaying = OpenReplayReader(&replay_reader, replay_path);
+        if (replaying) {
+            rows = replay_reader.rows;
+            columns = replay_reader.columns;
+            seed = replay_reader.seed;
+        } else {
+            TraceLog(LOG_WARNING, "REPLAY: Could not read %s", replay_path);
+        }
+    }
+
+    InitGame(&game, rows, columns, seed);
+
+    ReplayWriter replay_writer;
+    bool recording = false;
+    if (record_path) {
+        recording = OpenReplayWriter(&replay_writer, record_path, rows, columns, seed);
+        if (!recording) {
+            TraceLog(LOG_WARNING, "REPLAY: Could not create %s", record_path);
+        }
+    }
+    gridLayout = GetGridLayout(rows, columns);
+
+    // Screen effects get their own stream so they never shift food placement
+    Random effects_random;
+    SeedRandom(&effects_random, ~seed);
+
+    // F2 cycles through the tile renderers. The GPU one is skipped if its
+    // shader failed to compile.
+    TileGpuRenderer tile_gpu_renderer = {0};
+    bool has_gpu_renderer = LoadTileGpuRenderer(&tile_gpu_renderer);
+    TileRenderer tile_renderer = has_gpu_renderer ? TILE_RENDER_GPU : TILE_RENDER_BATCHED;
+
+    int status = 0;
+    if (bench_frames > 0) {
+        Random bot_random;
+        SeedRandom(&bot_random, ~seed);
+        for (size_t step = 0; step < POST_BENCH_STEPS && !game.game_over; step++) {
+            SnakeHandleInput(&game.player, BotChooseInput(&game, &bot_random));
+            GameStep(&game);
+        }
+        status = RunPostBenchmark(&post, &profiler, target, &tile_gpu_renderer, has_gpu_renderer, bench_frames, bench_png);
+    }
+
+    // Only a game played by hand gets a timeline to rewind. The post
+    // benchmark never steps the game, a replay file has no way to record a
+    // rewind, and a replay being played back is already on disk.
+    bool can_rewind = bench_frames == 0 && !recording && !replaying;
+    Timeline timeline = {0};
+    if (can_rewind) {
+        InitTimeline(&timeline, &game, TIMELINE_DEFAULT_POOL_SIZE);
+    }
+    bool rewinding = false;
 
-    bool foodWasEaten = false;
-    float stepTimer = 0;
+    double stepAccumulator = 0;
+    double scrubAccumulator = 0;
     float globalTimer = 0;
-    while (!WindowShouldClose()) {
+    while (bench_frames == 0 && !WindowShouldClose()) {
         float dt = GetFrameTime();
-        stepTimer += dt;
+        stepAccumulator += dt;
         globalTimer += dt;
+        BeginProfileStage(&profiler, PROFILE_FRAME);
 
-        SnakeHandleInput(&game.player);
+        BeginProfileStage(&profiler, PROFILE_INPUT);
+        unsigned input = ReadInput();
+        if (!replaying && !rewinding) {
+            SnakeHandleInput(&game.player, input);
+        }
+        // Backspace pauses and rewinds, and pressed again plays on from the
+        // step shown, dropping the steps that came after
+        if (IsKeyPressed(KEY_BACKSPACE) && can_rewind) {
+            rewinding = !rewinding;
+            scrubAccumulator = 0;
+        }
+        // F8 shows the profiler, F9 starts and stops recording it to CSV
+        if (IsKeyPressed(KEY_F8)) {
+            profiler.visible = !profiler.visible;
+        }
+        if (IsKeyPressed(KEY_F9)) {
+            if (profiler.csv) {
+                StopProfileCsv(&profiler);
+            } else {
+                StartProfileCsv(&profiler, TextFormat("profile-%ld.csv", (long)time(nullptr)));
+            }
+        }
+        // F3 switches between the bloom modes
+        if (IsKeyPressed(KEY_F3)) {
+            post.bloom_mode = (post.bloom_mode + 1) % BLOOM_MODE_COUNT;
+        }
+        // F6 picks the post quality by hand, F7 hands it back to the governor
+        if (IsKeyPressed(KEY_F6)) {
+            post.quality = (post.quality + 1) % POST_QUALITY_COUNT;
+            governor.enabled = false;
+        }
+        if (IsKeyPressed(KEY_F7)) {
+            InitQualityGovernor(&governor, governor.budget);
+        }
+        UpdateQualityGovernor(&governor, &post, dt);
+        // F5 switches between the separate and fused final passes
+        if (IsKeyPressed(KEY_F5)) {
+            post.composite_mode = (post.composite_mode + 1) % COMPOSITE_MODE_COUNT;
+        }
+        // F4 toggles the linear sampling blur, [ and ] set the blur passes and
+        // , and . the linear blur radius (all for the ping-pong bloom)
+        if (IsKeyPressed(KEY_F4)) {
+            post.linear_blur = !post.linear_blur;
+        }
+        if (IsKeyPressed(KEY_LEFT_BRACKET) && post.blur_iterations > 1) {
+            post.blur_iterations--;
+        }
+        if (IsKeyPressed(KEY_RIGHT_BRACKET) && post.blur_iterations < BLUR_MAX_ITERATIONS) {
+            post.blur_iterations++;
+        }
+        if (IsKeyPressed(KEY_COMMA)) {
+            SetBlurRadius(&post, post.blur_radius - 1);
+        }
+        if (IsKeyPressed(KEY_PERIOD)) {
+            SetBlurRadius(&post, post.blur_radius + 1);
+        }
+        if (IsKeyPressed(KEY_F2)) {
+            tile_renderer = (tile_renderer + 1) % TILE_RENDER_COUNT;
+            if (tile_renderer == TILE_RENDER_GPU && !has_gpu_renderer) {
+                tile_renderer = (tile_renderer + 1) % TILE_RENDER_COUNT;
+            }
+            if (tile_renderer == TILE_RENDER_GPU) {
+                tile_gpu_renderer.needs_full_upload = true;
+            }
+        }
+
+        EndProfileStage(&profiler, PROFILE_INPUT);
 
-        UpdateTileGrid(dt);
+        BeginProfileStage(&profiler, PROFILE_UPDATE_TILES);
+        UpdateTileGrid(dt, tile_renderer != TILE_RENDER_GPU);
+        EndProfileStage(&profiler, PROFILE_UPDATE_TILES);
         UpdateScaleEffect(&scale_effect, dt);
         UpdateShakeEffect(&shake_effect, dt);
         UpdateScoreEffect(&score_effect, dt);
 
-        if (stepTimer >= STEP_INTERVAL) {
-            MoveClones();
-
-            if (!game.game_over) {
-                SnakeDoStep(&game.player);
-
-                Position *head = &game.player.tiles[0];
-                if (head->row == game.food.position.row && head->column == game.food.position.column) {
-                    ReduceClones();
-                    SpawnClone(&game.player);
-                    SnakeGrow(&game.player);
-                    foodWasEaten = true;
-                    score_effect.duration = SCORE_ANIMATION_DURATION;
-                    score_effect.angle = GetRandomValue(-10, 10);
-                    score_effect.scale = 1.3;
+        BeginProfileStage(&profiler, PROFILE_STEPS);
+        // While rewinding, left and right step through the timeline, a step
+        // per press or continuously while held
+        if (rewinding) {
+            stepAccumulator = 0;
+            int scrub = IsKeyDown(KEY_RIGHT) - IsKeyDown(KEY_LEFT);
+            bool fast = IsKeyDown(KEY_LEFT_SHIFT) || IsKeyDown(KEY_RIGHT_SHIFT);
+            scrubAccumulator = scrub ? scrubAccumulator + scrub * REWIND_STEPS_PER_SECOND * (fast ? 10 : 1) * dt : 0;
+            int64_t delta = (int64_t)scrubAccumulator + IsKeyPressed(KEY_RIGHT) - IsKeyPressed(KEY_LEFT);
+            scrubAccumulator -= (int64_t)scrubAccumulator;
+
+            int64_t target = (int64_t)timeline.cursor + delta;
+            int64_t first = TimelineFirstStep(&timeline);
+            target = target < first ? first : target;
+            target = target > (int64_t)timeline.step ? (int64_t)timeline.step : target;
+            TimelineSeek(&timeline, &game, target);
+        }
+        // Fixed timestep: run as many ticks as the elapsed time calls for and
+        // carry the remainder over, so game speed does not depend on the
+        // frame rate. After a long stall the backlog is dropped rather than
+        // replayed in one burst.
+        int steps = 0;
+        while (stepAccumulator >= STEP_INTERVAL && steps < MAX_STEPS_PER_FRAME) {
+            if (replaying) {
+                ReplayAction action = NextReplayAction(&replay_reader, &game);
+                while (action == REPLAY_RESTART) {
+                    RestartGame(&game);
+                    action = NextReplayAction(&replay_reader, &game);
+                }
+                // The board stays as the recording left it
+                if (action == REPLAY_END) {
+                    stepAccumulator = 0;
+                    break;
                 }
+            }
+            if (recording) {
+                RecordReplayStep(&replay_writer, &game);
+            }
+            unsigned events = can_rewind ? TimelineStep(&timeline, &game) : GameStep(&game);
+
+            if (events & STEP_FOOD_EATEN) {
+                score_effect.duration = SCORE_ANIMATION_DURATION;
+                score_effect.angle = RandomRange(&effects_random, -10, 10);
+                score_effect.scale = 1.3;
+            }
 
-                game.game_over = CheckForCollisions(&game.player);
-                if (game.game_over) {
-                    scale_effect.scale = 1.3;
-                    shake_effect.duration = 0.3;
+            if (events & STEP_GAME_OVER) {
+                scale_effect.scale = 1.3;
+                shake_effect.duration = 0.3;
+                // Nobody is steering now, so this is the time to write
+                if (recording) {
+                    FlushReplayWriter(&replay_writer);
                 }
             }
 
-            stepTimer = 0;
+            stepAccumulator -= STEP_INTERVAL;
+            steps++;
         }
-
-        SnakeMarkTiles(&game.player);
-        ClonesMarkTiles();
-        if (foodWasEaten) {
-            foodWasEaten = false;
-            PlaceFoodRandomly(&game.food);
+        if (stepAccumulator >= STEP_INTERVAL) {
+            stepAccumulator = fmod(stepAccumulator, STEP_INTERVAL);
         }
-        FoodMarkTile(&game.food);
+        EndProfileStage(&profiler, PROFILE_STEPS);
+
+        BeginProfileStage(&profiler, PROFILE_MARK_TILES);
+        GameMarkTiles(&game);
+        EndProfileStage(&profiler, PROFILE_MARK_TILES);
 
+        BeginGpuProfile(&profiler);
+        BeginProfileStage(&profiler, PROFILE_DRAW_TILES);
         BeginTextureMode(target);
             ClearBackground(BLACK);
-            DrawTileGrid();
+            switch (tile_renderer) {
+                case TILE_RENDER_IMMEDIATE:
+                    DrawTileGrid();
+                    break;
+                case TILE_RENDER_BATCHED:
+                    DrawTileGridBatched();
+                    break;
+                case TILE_RENDER_GPU:
+                    DrawTileGridGpu(&tile_gpu_renderer);
+                    break;
+                case TILE_RENDER_COUNT:
+                    break;
+            }
+            EndProfileStage(&profiler, PROFILE_DRAW_TILES);
             DrawScore(&score_effect);
-            if (game.game_over) {
+            if (rewinding) {
+                DrawRewind(&timeline);
+            } else if (game.game_over) {
                 DrawGameOver();
             }
             DrawFPS(10, 10);
         EndTextureMode();
+        MarkGpuProfile(&profiler, "scene");
 
-        BeginTextureMode(tmpA);
-            ClearBackground(BLACK);
-            BeginShaderMode(thresholdShader);
-                DrawTexturePro(
-                    target.texture,
-                    (Rectangle) {0, 0, target.texture.width, -target.texture.height},
-                    (Rectangle) {0, 0, tmpA.texture.width, tmpA.texture.height},
-                    (Vector2) {0},
-                    0,
-                    WHITE
-                );
-            EndShaderMode();
-        EndTextureMode();
-
-        for (size_t i = 0; i < 10; i++) {
-            BeginTextureMode(tmpB);
-                ClearBackground(BLACK);
-                BeginShaderMode(blurShader);
-                    SetShaderValue(blurShader, blurDirectionLoc, &(Vector2) {1.0 / tmpA.texture.width, 0}, SHADER_UNIFORM_VEC2);
-                    DrawTexturePro(
-                        tmpA.texture,
-                        (Rectangle) {0, 0, tmpA.texture.width, -tmpA.texture.height},
-                        (Rectangle) {0, 0, tmpB.texture.width, tmpB.texture.height},
-                        (Vector2) {0},
-                        0,
-                        WHITE
-                    );
-                EndShaderMode();
-            EndTextureMode();
-
-            BeginTextureMode(tmpA);
-                ClearBackground(BLACK);
-                BeginShaderMode(blurShader);
-                    SetShaderValue(blurShader, blurDirectionLoc, &(Vector2) {0, 1.0 / tmpB.texture.height}, SHADER_UNIFORM_VEC2);
-                    DrawTexturePro(
-                        tmpB.texture,
-                        (Rectangle) {0, 0, tmpB.texture.width, -tmpB.texture.height},
-                        (Rectangle) {0, 0, tmpA.texture.width, tmpA.texture.height},
-                        (Vector2) {0},
-                        0,
-                        WHITE
-                    );
-                EndShaderMode();
-            EndTextureMode();
-        }
-
-        BeginTextureMode(blurred);
-            ClearBackground(BLACK);
-            DrawTexturePro(
-                target.texture,
-                (Rectangle) {0, 0, target.texture.width, -target.texture.height},
-                (Rectangle) {0, 0, blurred.texture.width, blurred.texture.height},
-                (Vector2) {0},
-                0,
-                WHITE
-            );
-
-            BeginBlendMode(BLEND_ADDITIVE);
-                DrawTexturePro(
-                    tmpA.texture,
-                    (Rectangle) {0, 0, tmpA.texture.width, -tmpA.texture.height},
-                    (Rectangle) {0, 0, blurred.texture.width, blurred.texture.height},
-                    (Vector2) {0},
-                    0,
-                    WHITE
-                );
-            EndBlendMode();
-        EndTextureMode();
-
-        BeginTextureMode(scanlined);
-            ClearBackground(BLACK);
-            BeginShaderMode(scanlineShader);
-                SetShaderValue(scanlineShader, scanlineTimeLoc, &globalTimer, SHADER_UNIFORM_FLOAT);
-                DrawTexturePro(
-                    blurred.texture,
-                    (Rectangle) {0, 0, blurred.texture.width, -blurred.texture.height},
-                    (Rectangle) {0, 0, scanlined.texture.width, scanlined.texture.height},
-                    (Vector2) {0},
-                    0,
-                    WHITE
-                );
-            EndShaderMode();
-        EndTextureMode();
+        BeginProfileStage(&profiler, PROFILE_POST);
+        RunPostChain(&post, target.texture, globalTimer);
 
         BeginDrawing();
             ClearBackground(BLACK);
@@ -711,8 +906,8 @@ int main(void) {
 
             Vector2 shake_offset = {0};
             if (shake_effect.duration > 0) {
-                shake_offset.x = GetRandomValue(-shake_effect.intensity, shake_effect.intensity);
-                shake_offset.y = GetRandomValue(-shake_effect.intensity, shake_effect.intensity);
+                shake_offset.x = RandomRange(&effects_random, -shake_effect.intensity, shake_effect.intensity);
+                shake_offset.y = RandomRange(&effects_random, -shake_effect.intensity, shake_effect.intensity);
             }
 
             Rectangle destination = (Rectangle) {
@@ -722,22 +917,43 @@ int main(void) {
                 .height = scaledHeight
             };
 
-            DrawTexturePro(
-                scanlined.texture,
-                (Rectangle) {0, 0, GAME_WIDTH, -GAME_HEIGHT},
-                destination,
-                (Vector2) { 0 },
-                0,
-                WHITE
-            );
+            DrawPostChain(&post, target.texture, destination, globalTimer);
+            MarkGpuProfile(&profiler, "screen");
+            EndGpuProfile(&profiler);
+            EndProfileStage(&profiler, PROFILE_POST);
+            EndProfileStage(&profiler, PROFILE_FRAME);
+
+            DrawProfiler(&profiler, WINDOW_WIDTH - 280, 10);
         EndDrawing();
 
-        if (game.game_over && IsKeyPressed(KEY_ENTER)) {
-            RestartGame();
+        if (game.game_over && !replaying && !rewinding && IsKeyPressed(KEY_ENTER)) {
+            RestartGame(&game);
+            if (can_rewind) {
+                TimelineRecordRestart(&timeline);
+            }
+            if (recording) {
+                RecordReplayRestart(&replay_writer);
+            }
         }
     }
 
+    if (recording) {
+        CloseReplayWriter(&replay_writer);
+    }
+    if (replaying) {
+        CloseReplayReader(&replay_reader);
+    }
+    if (can_rewind) {
+        FreeTimeline(&timeline);
+    }
+
+    if (has_gpu_renderer) {
+        UnloadTileGpuRenderer(&tile_gpu_renderer);
+    }
+    UnloadPostChain(&post);
+    UnloadProfiler(&profiler);
+    FreeGame(&game);
     CloseWindow();
 
-    return 0;
+    return status;
 }
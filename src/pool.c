@@ -0,0 +1,148 @@
+#include <pthread.h>
+#include <stdlib.h>
+
+#include "pool.h"
+#include "random.h"
+
+void InitWorkQueue(WorkQueue *queue, size_t capacity) {
+    atomic_init(&queue->top, 0);
+    atomic_init(&queue->bottom, 0);
+    queue->tasks = malloc(sizeof(size_t) * (capacity > 0 ? capacity : 1));
+    queue->capacity = capacity > 0 ? capacity : 1;
+}
+
+void FreeWorkQueue(WorkQueue *queue) {
+    free(queue->tasks);
+    queue->tasks = nullptr;
+    queue->capacity = 0;
+}
+
+// Tasks are all pushed before the workers start, so the queue never wraps
+// around and never needs to grow.
+void WorkQueuePush(WorkQueue *queue, size_t task) {
+    long bottom = atomic_load_explicit(&queue->bottom, memory_order_relaxed);
+    queue->tasks[bottom % queue->capacity] = task;
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&queue->bottom, bottom + 1, memory_order_relaxed);
+}
+
+bool WorkQueuePop(WorkQueue *queue, size_t *task) {
+    long bottom = atomic_load_explicit(&queue->bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit(&queue->bottom, bottom, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    long top = atomic_load_explicit(&queue->top, memory_order_relaxed);
+
+    if (top > bottom) {
+        atomic_store_explicit(&queue->bottom, bottom + 1, memory_order_relaxed);
+        return false;
+    }
+
+    *task = queue->tasks[bottom % queue->capacity];
+    if (top == bottom) {
+        // Last task: race the thieves for it
+        bool won = atomic_compare_exchange_strong_explicit(&queue->top, &top, top + 1, memory_order_seq_cst, memory_order_relaxed);
+        atomic_store_explicit(&queue->bottom, bottom + 1, memory_order_relaxed);
+        return won;
+    }
+    return true;
+}
+
+// Returns false only when the queue was seen empty; lost races are retried
+bool WorkQueueSteal(WorkQueue *queue, size_t *task) {
+    for (;;) {
+        long top = atomic_load_explicit(&queue->top, memory_order_acquire);
+        atomic_thread_fence(memory_order_seq_cst);
+        long bottom = atomic_load_explicit(&queue->bottom, memory_order_acquire);
+
+        if (top >= bottom) {
+            return false;
+        }
+
+        size_t value = queue->tasks[top % queue->capacity];
+        if (atomic_compare_exchange_strong_explicit(&queue->top, &top, top + 1, memory_order_seq_cst, memory_order_relaxed)) {
+            *task = value;
+            return true;
+        }
+    }
+}
+
+typedef struct {
+    TaskPool *pool;
+    size_t worker;
+} Worker;
+
+void *WorkerMain(void *arg) {
+    Worker *self = arg;
+    TaskPool *pool = self->pool;
+    WorkQueue *own = &pool->queues[self->worker];
+    Random random;
+    SeedRandom(&random, self->worker);
+
+    for (;;) {
+        size_t task;
+        while (WorkQueuePop(own, &task)) {
+            pool->function(pool->context, task, self->worker);
+        }
+
+        // No task is ever pushed once the workers run, so a full sweep over
+        // empty queues means all the work has been handed out.
+        bool stolen = false;
+        size_t start = RandomBelow(&random, pool->worker_count);
+        for (size_t i = 0; i < pool->worker_count && !stolen; i++) {
+            size_t victim = (start + i) % pool->worker_count;
+            if (victim != self->worker) {
+                stolen = WorkQueueSteal(&pool->queues[victim], &task);
+            }
+        }
+
+        if (!stolen) {
+            return nullptr;
+        }
+        pool->function(pool->context, task, self->worker);
+    }
+}
+
+// Runs function(context, task, worker) for every task in [0, task_count) on
+// worker_count threads, the calling thread being worker 0.
+void RunTasks(size_t worker_count, size_t task_count, TaskFunction function, void *context) {
+    if (worker_count == 0) {
+        worker_count = 1;
+    }
+
+    TaskPool pool = (TaskPool) {
+        .worker_count = worker_count,
+        .queues = malloc(sizeof(WorkQueue) * worker_count),
+        .function = function,
+        .context = context
+    };
+
+    for (size_t i = 0; i < worker_count; i++) {
+        InitWorkQueue(&pool.queues[i], task_count / worker_count + 1);
+    }
+    for (size_t task = 0; task < task_count; task++) {
+        WorkQueuePush(&pool.queues[task % worker_count], task);
+    }
+
+    Worker *workers = malloc(sizeof(Worker) * worker_count);
+    pthread_t *threads = malloc(sizeof(pthread_t) * worker_count);
+    for (size_t i = 0; i < worker_count; i++) {
+        workers[i] = (Worker) {
+            .pool = &pool,
+            .worker = i
+        };
+    }
+    for (size_t i = 1; i < worker_count; i++) {
+        pthread_create(&threads[i], nullptr, WorkerMain, &workers[i]);
+    }
+    WorkerMain(&workers[0]);
+    for (size_t i = 1; i < worker_count; i++) {
+        pthread_join(threads[i], nullptr);
+    }
+
+    for (size_t i = 0; i < worker_count; i++) {
+        FreeWorkQueue(&pool.queues[i]);
+    }
+    free(pool.queues);
+    free(workers);
+    free(threads);
+}
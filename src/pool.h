@@ -0,0 +1,33 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+
+typedef void (*TaskFunction)(void *context, size_t task, size_t worker);
+
+// Chase-Lev deque of task indices. Only the owning worker pushes and pops at
+// the bottom; idle workers steal from the top.
+typedef struct {
+    atomic_long top;
+    atomic_long bottom;
+    size_t *tasks;
+    size_t capacity;
+} WorkQueue;
+
+typedef struct {
+    size_t worker_count;
+    WorkQueue *queues;
+    TaskFunction function;
+    void *context;
+} TaskPool;
+
+void InitWorkQueue(WorkQueue *queue, size_t capacity);
+void FreeWorkQueue(WorkQueue *queue);
+void WorkQueuePush(WorkQueue *queue, size_t task);
+bool WorkQueuePop(WorkQueue *queue, size_t *task);
+bool WorkQueueSteal(WorkQueue *queue, size_t *task);
+
+void RunTasks(size_t worker_count, size_t task_count, TaskFunction function, void *context);
+
+#endif
@@ -0,0 +1,388 @@
+#include <math.h>
+#include <rlgl.h>
+
+#include "post.h"
+
+// Upsampling tent radius in source texels, picked so the mip chain spreads
+// light about as far as the ten full resolution blur passes (sigma ~5.3px)
+#define BLOOM_UPSAMPLE_RADIUS 0.57
+
+// Frames are judged in windows of this many seconds. A window over
+// QUALITY_DOWNGRADE_RATIO of the budget drops a tier; upgrades need windows
+// within QUALITY_UPGRADE_RATIO, and each failed upgrade doubles the wait.
+#define QUALITY_WINDOW 0.5
+#define QUALITY_DOWNGRADE_RATIO 1.1
+#define QUALITY_UPGRADE_RATIO 1.02
+#define QUALITY_UPGRADE_DELAY 2.0
+#define QUALITY_MAX_UPGRADE_DELAY 60.0
+
+void LoadPostChain(PostChain *post, int width, int height) {
+    post->width = width;
+    post->height = height;
+    post->bloom_mode = BLOOM_MIP_CHAIN;
+    post->composite_mode = COMPOSITE_FUSED;
+    post->quality = POST_QUALITY_FULL;
+    post->profiler = nullptr;
+    post->linear_blur = true;
+    post->blur_iterations = 10;
+    SetBlurRadius(post, 4);
+
+    post->tmpA = LoadRenderTexture(width, height);
+    post->tmpB = LoadRenderTexture(width, height);
+    post->blurred = LoadRenderTexture(width, height);
+    post->scanlined = LoadRenderTexture(width, height);
+    // The linear sampling blur reads between texels; blur.glsl reads texel
+    // centers, where bilinear filtering changes nothing
+    SetTextureFilter(post->tmpA.texture, TEXTURE_FILTER_BILINEAR);
+    SetTextureFilter(post->tmpB.texture, TEXTURE_FILTER_BILINEAR);
+    post->halfA = LoadRenderTexture(width / 2, height / 2);
+    post->halfB = LoadRenderTexture(width / 2, height / 2);
+    SetTextureFilter(post->halfA.texture, TEXTURE_FILTER_BILINEAR);
+    SetTextureFilter(post->halfB.texture, TEXTURE_FILTER_BILINEAR);
+
+    // Bilinear filtering does the box filter on the way down and the
+    // interpolation on the way up; clamping keeps the edges from wrapping
+    for (int i = 0; i < BLOOM_MIP_LEVELS; i++) {
+        post->mips[i] = LoadRenderTexture(width >> (i + 1), height >> (i + 1));
+        SetTextureFilter(post->mips[i].texture, TEXTURE_FILTER_BILINEAR);
+        SetTextureWrap(post->mips[i].texture, TEXTURE_WRAP_CLAMP);
+    }
+
+    post->thresholdShader = LoadShader(0, "assets/shaders/threshold.glsl");
+    post->blurShader = LoadShader(0, "assets/shaders/blur.glsl");
+    post->blurDirectionLoc = GetShaderLocation(post->blurShader, "direction");
+    post->linearBlurShader = LoadShader(0, "assets/shaders/blur_linear.glsl");
+    post->linearBlurDirectionLoc = GetShaderLocation(post->linearBlurShader, "direction");
+    post->linearBlurTapCountLoc = GetShaderLocation(post->linearBlurShader, "tapCount");
+    post->linearBlurOffsetsLoc = GetShaderLocation(post->linearBlurShader, "offsets");
+    post->linearBlurWeightsLoc = GetShaderLocation(post->linearBlurShader, "weights");
+    post->prefilterShader = LoadShader(0, "assets/shaders/bloom_prefilter.glsl");
+    post->prefilterTexelSizeLoc = GetShaderLocation(post->prefilterShader, "texelSize");
+    post->upsampleShader = LoadShader(0, "assets/shaders/bloom_upsample.glsl");
+    post->upsampleTexelSizeLoc = GetShaderLocation(post->upsampleShader, "texelSize");
+    post->upsampleRadiusLoc = GetShaderLocation(post->upsampleShader, "radius");
+    post->scanlineShader = LoadShader(0, "assets/shaders/scanline.glsl");
+    post->scanlineTimeLoc = GetShaderLocation(post->scanlineShader, "time");
+    post->compositeShader = LoadShader(0, "assets/shaders/post_composite.glsl");
+    post->compositeBloomLoc = GetShaderLocation(post->compositeShader, "bloom");
+    post->compositeTimeLoc = GetShaderLocation(post->compositeShader, "time");
+}
+
+void UnloadPostChain(PostChain *post) {
+    UnloadRenderTexture(post->tmpA);
+    UnloadRenderTexture(post->tmpB);
+    UnloadRenderTexture(post->halfA);
+    UnloadRenderTexture(post->halfB);
+    UnloadRenderTexture(post->blurred);
+    UnloadRenderTexture(post->scanlined);
+    for (int i = 0; i < BLOOM_MIP_LEVELS; i++) {
+        UnloadRenderTexture(post->mips[i]);
+    }
+
+    UnloadShader(post->thresholdShader);
+    UnloadShader(post->blurShader);
+    UnloadShader(post->linearBlurShader);
+    UnloadShader(post->prefilterShader);
+    UnloadShader(post->upsampleShader);
+    UnloadShader(post->scanlineShader);
+    UnloadShader(post->compositeShader);
+}
+
+// Builds the kernel for the linear sampling blur. Texel weights are the
+// binomial row 2R + 4 with the two outermost entries on each side dropped,
+// which for R = 4 is exactly blur.glsl's table. Neighbouring texels are then
+// merged pairwise into one tap at their weighted mean offset.
+void SetBlurRadius(PostChain *post, int radius) {
+    if (radius < 1) radius = 1;
+    if (radius > BLUR_MAX_RADIUS) radius = BLUR_MAX_RADIUS;
+
+    int n = 2 * radius + 4;
+    double texel_weights[BLUR_MAX_RADIUS + 1];
+    double total = 0;
+    for (int k = 0; k <= radius; k++) {
+        // C(n, n / 2 + k)
+        texel_weights[k] = exp(lgamma(n + 1) - lgamma(n / 2 + k + 1) - lgamma(n / 2 - k + 1));
+        total += k == 0 ? texel_weights[k] : 2 * texel_weights[k];
+    }
+
+    post->blur_radius = radius;
+    post->blur_offsets[0] = 0;
+    post->blur_weights[0] = texel_weights[0] / total;
+    post->blur_taps = 1;
+    for (int k = 1; k <= radius; k += 2) {
+        double a = texel_weights[k];
+        double b = k + 1 <= radius ? texel_weights[k + 1] : 0;
+        post->blur_offsets[post->blur_taps] = (k * a + (k + 1) * b) / (a + b);
+        post->blur_weights[post->blur_taps] = (a + b) / total;
+        post->blur_taps++;
+    }
+}
+
+// Render textures are stored upside down, so every copy between them flips
+void DrawRenderTexture(Texture2D source, RenderTexture2D destination) {
+    DrawTexturePro(
+        source,
+        (Rectangle) {0, 0, source.width, -source.height},
+        (Rectangle) {0, 0, destination.texture.width, destination.texture.height},
+        (Vector2) {0},
+        0,
+        WHITE
+    );
+}
+
+void AddPostPass(PostChain *post, PostPass pass) {
+    post->passes[post->pass_count++] = pass;
+}
+
+// Runs the queued passes in order. Overwriting passes draw with blending
+// off, so only a target whose first pass adds onto it is cleared. Passes
+// into the same target share one BeginTextureMode, and since
+// BeginTextureMode flushes and rebinds on its own, the chain only goes back
+// to the screen framebuffer once, after the last pass.
+void ExecutePostPasses(const PostPass *passes, int count, Profiler *profiler) {
+    rlSetBlendFactors(RL_ONE, RL_ZERO, RL_FUNC_ADD);
+
+    const RenderTexture2D *bound = nullptr;
+    for (int i = 0; i < count; i++) {
+        const PostPass *pass = &passes[i];
+        if (pass->target != bound) {
+            BeginTextureMode(*pass->target);
+            bound = pass->target;
+            if (pass->blend != POST_OVERWRITE) {
+                ClearBackground(BLACK);
+            }
+        }
+
+        BeginBlendMode(pass->blend == POST_OVERWRITE ? BLEND_CUSTOM : BLEND_ADDITIVE);
+        if (pass->shader) {
+            BeginShaderMode(*pass->shader);
+            if (pass->vec2Loc != -1) {
+                SetShaderValue(*pass->shader, pass->vec2Loc, &pass->vec2, SHADER_UNIFORM_VEC2);
+            }
+        } else {
+            EndShaderMode();
+        }
+        DrawRenderTexture(pass->source, *pass->target);
+        if (profiler) {
+            MarkGpuProfile(profiler, pass->name);
+        }
+    }
+
+    if (bound) {
+        EndShaderMode();
+        EndBlendMode();
+        EndTextureMode();
+    }
+}
+
+Texture2D BloomPingPong(PostChain *post, Texture2D scene) {
+    RenderTexture2D *a = &post->tmpA;
+    RenderTexture2D *b = &post->tmpB;
+    int iterations = post->blur_iterations;
+    if (post->quality == POST_QUALITY_HALF) {
+        // The prefilter thresholds and halves in one pass. Each pass now
+        // spreads twice as far, and spread grows with the square root of
+        // the pass count, so a quarter of the passes covers the same area.
+        a = &post->halfA;
+        b = &post->halfB;
+        iterations = (iterations + 3) / 4;
+        AddPostPass(post, (PostPass) {
+            .name = "prefilter",
+            .target = a,
+            .source = scene,
+            .shader = &post->prefilterShader,
+            .vec2Loc = post->prefilterTexelSizeLoc,
+            .vec2 = (Vector2) {1.0 / scene.width, 1.0 / scene.height},
+            .blend = POST_OVERWRITE
+        });
+    } else {
+        AddPostPass(post, (PostPass) {
+            .name = "threshold",
+            .target = a,
+            .source = scene,
+            .shader = &post->thresholdShader,
+            .vec2Loc = -1,
+            .blend = POST_OVERWRITE
+        });
+    }
+
+    const Shader *shader = &post->blurShader;
+    int directionLoc = post->blurDirectionLoc;
+    if (post->linear_blur) {
+        shader = &post->linearBlurShader;
+        directionLoc = post->linearBlurDirectionLoc;
+        SetShaderValue(*shader, post->linearBlurTapCountLoc, &post->blur_taps, SHADER_UNIFORM_INT);
+        SetShaderValueV(*shader, post->linearBlurOffsetsLoc, post->blur_offsets, SHADER_UNIFORM_FLOAT, post->blur_taps);
+        SetShaderValueV(*shader, post->linearBlurWeightsLoc, post->blur_weights, SHADER_UNIFORM_FLOAT, post->blur_taps);
+    }
+
+    for (int i = 0; i < iterations; i++) {
+        AddPostPass(post, (PostPass) {
+            .name = "blur x",
+            .target = b,
+            .source = a->texture,
+            .shader = shader,
+            .vec2Loc = directionLoc,
+            .vec2 = (Vector2) {1.0 / a->texture.width, 0},
+            .blend = POST_OVERWRITE
+        });
+        AddPostPass(post, (PostPass) {
+            .name = "blur y",
+            .target = a,
+            .source = b->texture,
+            .shader = shader,
+            .vec2Loc = directionLoc,
+            .vec2 = (Vector2) {0, 1.0 / b->texture.height},
+            .blend = POST_OVERWRITE
+        });
+    }
+
+    return a->texture;
+}
+
+// Thresholds the scene into the 1/2 level, box filters down to 1/8, then
+// tent filters back up, each level overwriting the one above it. Every pass
+// after the first touches a quarter of the pixels of the one before.
+Texture2D BloomMipChain(PostChain *post, Texture2D scene) {
+    AddPostPass(post, (PostPass) {
+        .name = "prefilter",
+        .target = &post->mips[0],
+        .source = scene,
+        .shader = &post->prefilterShader,
+        .vec2Loc = post->prefilterTexelSizeLoc,
+        .vec2 = (Vector2) {1.0 / scene.width, 1.0 / scene.height},
+        .blend = POST_OVERWRITE
+    });
+
+    for (int i = 1; i < BLOOM_MIP_LEVELS; i++) {
+        AddPostPass(post, (PostPass) {
+            .name = "downsample",
+            .target = &post->mips[i],
+            .source = post->mips[i - 1].texture,
+            .vec2Loc = -1,
+            .blend = POST_OVERWRITE
+        });
+    }
+
+    SetShaderValue(post->upsampleShader, post->upsampleRadiusLoc, &(float) {BLOOM_UPSAMPLE_RADIUS}, SHADER_UNIFORM_FLOAT);
+    int top = post->quality == POST_QUALITY_HALF ? 1 : 0;
+    for (int i = BLOOM_MIP_LEVELS - 1; i > top; i--) {
+        Texture2D source = post->mips[i].texture;
+        AddPostPass(post, (PostPass) {
+            .name = "upsample",
+            .target = &post->mips[i - 1],
+            .source = source,
+            .shader = &post->upsampleShader,
+            .vec2Loc = post->upsampleTexelSizeLoc,
+            .vec2 = (Vector2) {1.0 / source.width, 1.0 / source.height},
+            .blend = POST_OVERWRITE
+        });
+    }
+
+    return post->mips[top].texture;
+}
+
+void RunPostChain(PostChain *post, Texture2D scene, float time) {
+    post->pass_count = 0;
+    if (post->quality == POST_QUALITY_OFF) {
+        return;
+    }
+    post->bloom = post->bloom_mode == BLOOM_MIP_CHAIN ? BloomMipChain(post, scene) : BloomPingPong(post, scene);
+
+    if (post->composite_mode == COMPOSITE_SEPARATE) {
+        AddPostPass(post, (PostPass) {
+            .name = "composite",
+            .target = &post->blurred,
+            .source = scene,
+            .vec2Loc = -1,
+            .blend = POST_OVERWRITE
+        });
+        AddPostPass(post, (PostPass) {
+            .name = "bloom add",
+            .target = &post->blurred,
+            .source = post->bloom,
+            .vec2Loc = -1,
+            .blend = POST_ADD
+        });
+
+        SetShaderValue(post->scanlineShader, post->scanlineTimeLoc, &time, SHADER_UNIFORM_FLOAT);
+        AddPostPass(post, (PostPass) {
+            .name = "scanline",
+            .target = &post->scanlined,
+            .source = post->blurred.texture,
+            .shader = &post->scanlineShader,
+            .vec2Loc = -1,
+            .blend = POST_OVERWRITE
+        });
+    }
+
+    ExecutePostPasses(post->passes, post->pass_count, post->profiler);
+}
+
+// Draws the finished frame into the current target, which is the screen
+void DrawPostChain(PostChain *post, Texture2D scene, Rectangle destination, float time) {
+    Rectangle source = (Rectangle) {0, 0, scene.width, -scene.height};
+    if (post->quality == POST_QUALITY_OFF) {
+        DrawTexturePro(scene, source, destination, (Vector2) {0}, 0, WHITE);
+        return;
+    }
+    if (post->composite_mode == COMPOSITE_SEPARATE) {
+        DrawTexturePro(post->scanlined.texture, source, destination, (Vector2) {0}, 0, WHITE);
+        return;
+    }
+
+    BeginShaderMode(post->compositeShader);
+        SetShaderValueTexture(post->compositeShader, post->compositeBloomLoc, post->bloom);
+        SetShaderValue(post->compositeShader, post->compositeTimeLoc, &time, SHADER_UNIFORM_FLOAT);
+        DrawTexturePro(scene, source, destination, (Vector2) {0}, 0, WHITE);
+    EndShaderMode();
+}
+
+void InitQualityGovernor(QualityGovernor *governor, float budget) {
+    *governor = (QualityGovernor) {
+        .enabled = true,
+        .budget = budget,
+        .upgrade_delay = QUALITY_UPGRADE_DELAY
+    };
+}
+
+// With a capped frame rate the average sits right at the budget while there
+// is headroom, so headroom can only be found by trying the next tier up.
+void UpdateQualityGovernor(QualityGovernor *governor, PostChain *post, float dt) {
+    if (!governor->enabled) {
+        return;
+    }
+
+    governor->window_time += dt;
+    governor->window_frames++;
+    if (governor->window_time < QUALITY_WINDOW) {
+        return;
+    }
+    float average = governor->window_time / governor->window_frames;
+    governor->window_time = 0;
+    governor->window_frames = 0;
+
+    if (average > governor->budget * QUALITY_DOWNGRADE_RATIO) {
+        if (governor->probing) {
+            governor->upgrade_delay = fminf(governor->upgrade_delay * 2, QUALITY_MAX_UPGRADE_DELAY);
+        }
+        governor->probing = false;
+        governor->calm_time = 0;
+        if (post->quality > POST_QUALITY_OFF) {
+            post->quality--;
+        }
+    } else if (average <= governor->budget * QUALITY_UPGRADE_RATIO) {
+        if (governor->probing) {
+            governor->upgrade_delay = QUALITY_UPGRADE_DELAY;
+        }
+        governor->probing = false;
+        governor->calm_time += QUALITY_WINDOW;
+        if (governor->calm_time >= governor->upgrade_delay && post->quality < POST_QUALITY_FULL) {
+            post->quality++;
+            governor->probing = true;
+            governor->calm_time = 0;
+        }
+    } else {
+        governor->calm_time = 0;
+    }
+}
@@ -0,0 +1,146 @@
+#ifndef POST_H
+#define POST_H
+
+#include <raylib.h>
+
+#include "profiler.h"
+
+// Bloom halves: 1/2, 1/4 and 1/8 of the game resolution
+#define BLOOM_MIP_LEVELS 3
+
+#define BLUR_MAX_RADIUS 16
+#define BLUR_MAX_TAPS (BLUR_MAX_RADIUS / 2 + 1)
+#define BLUR_MAX_ITERATIONS 20
+
+// Threshold, two per blur iteration, then the separate composite's three
+#define POST_MAX_PASSES (1 + 2 * BLUR_MAX_ITERATIONS + 3)
+
+typedef enum {
+    // Threshold, then blur_iterations separable blur passes each way at full
+    // resolution
+    BLOOM_PING_PONG,
+    // Threshold while downsampling through the mip levels, then tent
+    // filtered upsampling back to half resolution
+    BLOOM_MIP_CHAIN,
+    BLOOM_MODE_COUNT
+} BloomMode;
+
+typedef enum {
+    // Scene plus bloom into blurred, scanlines into scanlined, then a copy
+    // to the screen
+    COMPOSITE_SEPARATE,
+    // One post_composite.glsl pass from the scene and bloom to the screen
+    COMPOSITE_FUSED,
+    COMPOSITE_MODE_COUNT
+} CompositeMode;
+
+typedef enum {
+    // The scene goes to the screen untouched
+    POST_QUALITY_OFF,
+    // Bloom at half resolution: the ping-pong blur runs on half size
+    // targets, and the mip chain stops upsampling at the 1/4 level
+    POST_QUALITY_HALF,
+    POST_QUALITY_FULL,
+    POST_QUALITY_COUNT
+} PostQuality;
+
+typedef enum {
+    // Replaces every pixel of the target, so the target needs no clear
+    POST_OVERWRITE,
+    // Adds onto what the earlier passes left in the target
+    POST_ADD
+} PostBlend;
+
+// One full-target draw of the post chain: source drawn into target through
+// shader (a plain copy when nullptr). vec2Loc, when not -1, is the shader's
+// per-pass vec2 uniform, a blur direction or texel size; uniforms that stay
+// the same all frame are set before the passes run.
+typedef struct {
+    const char *name;
+    RenderTexture2D *target;
+    Texture2D source;
+    const Shader *shader;
+    int vec2Loc;
+    Vector2 vec2;
+    PostBlend blend;
+} PostPass;
+
+// The post-processing chain run on the game render texture every frame:
+// bloom, the bloom added back onto the scene, then the CRT scanlines.
+// RunPostChain does the offscreen passes, DrawPostChain the one to the screen.
+// The offscreen passes are queued into passes first and then executed
+// together, which lets ExecutePostPasses skip clears and target switches.
+typedef struct {
+    int width;
+    int height;
+    BloomMode bloom_mode;
+    CompositeMode composite_mode;
+    PostQuality quality;
+    // Ping-pong blur settings. The linear sampling blur reads a radius R
+    // kernel in R / 2 + 1 fetches per side; blur.glsl is fixed at radius 4.
+    bool linear_blur;
+    int blur_radius;
+    int blur_iterations;
+    int blur_taps;
+    float blur_offsets[BLUR_MAX_TAPS];
+    float blur_weights[BLUR_MAX_TAPS];
+
+    RenderTexture2D tmpA;
+    RenderTexture2D tmpB;
+    RenderTexture2D halfA;
+    RenderTexture2D halfB;
+    RenderTexture2D mips[BLOOM_MIP_LEVELS];
+    RenderTexture2D blurred;
+    RenderTexture2D scanlined;
+    Texture2D bloom; // This frame's bloom, one of tmpA or mips[0]
+    PostPass passes[POST_MAX_PASSES];
+    int pass_count;
+    Profiler *profiler; // Optional, timestamps every pass on the GPU
+
+    Shader thresholdShader;
+    Shader blurShader;
+    int blurDirectionLoc;
+    Shader linearBlurShader;
+    int linearBlurDirectionLoc;
+    int linearBlurTapCountLoc;
+    int linearBlurOffsetsLoc;
+    int linearBlurWeightsLoc;
+    Shader prefilterShader;
+    int prefilterTexelSizeLoc;
+    Shader upsampleShader;
+    int upsampleTexelSizeLoc;
+    int upsampleRadiusLoc;
+    Shader scanlineShader;
+    int scanlineTimeLoc;
+    Shader compositeShader;
+    int compositeBloomLoc;
+    int compositeTimeLoc;
+} PostChain;
+
+// Moves the post quality between tiers to keep the average frame time within
+// budget. raylib has no GPU timers, so this goes by the whole frame time,
+// which includes waiting on the GPU when the buffers are swapped.
+typedef struct {
+    bool enabled;
+    float budget;        // Seconds per frame
+    float window_time;   // Frame times summed over the current window
+    int window_frames;
+    float calm_time;     // Time under budget since the last tier change
+    float upgrade_delay; // Calm time needed before trying the next tier up
+    bool probing;        // The last change was an upgrade still on trial
+} QualityGovernor;
+
+void LoadPostChain(PostChain *post, int width, int height);
+void UnloadPostChain(PostChain *post);
+void SetBlurRadius(PostChain *post, int radius);
+void DrawRenderTexture(Texture2D source, RenderTexture2D destination);
+void AddPostPass(PostChain *post, PostPass pass);
+void ExecutePostPasses(const PostPass *passes, int count, Profiler *profiler);
+Texture2D BloomPingPong(PostChain *post, Texture2D scene);
+Texture2D BloomMipChain(PostChain *post, Texture2D scene);
+void RunPostChain(PostChain *post, Texture2D scene, float time);
+void DrawPostChain(PostChain *post, Texture2D scene, Rectangle destination, float time);
+void InitQualityGovernor(QualityGovernor *governor, float budget);
+void UpdateQualityGovernor(QualityGovernor *governor, PostChain *post, float dt);
+
+#endif
@@ -0,0 +1,268 @@
+#include <stdlib.h>
+#include <string.h>
+#include <raylib.h>
+#include <rlgl.h>
+
+#include "profiler.h"
+
+#define GL_TIMESTAMP 0x8E28
+#define GL_QUERY_RESULT 0x8866
+#define GL_QUERY_RESULT_AVAILABLE 0x8867
+
+#if defined(_WIN32)
+#define PROFILE_APIENTRY __stdcall
+#else
+#define PROFILE_APIENTRY
+#endif
+
+// rlGetProcAddress arrived in raylib 5.5
+#if RAYLIB_VERSION_MAJOR > 5 || (RAYLIB_VERSION_MAJOR == 5 && RAYLIB_VERSION_MINOR >= 5)
+#define PROFILE_GPU_TIMERS
+#endif
+
+void (PROFILE_APIENTRY *glGenQueriesPtr)(int n, unsigned int *ids);
+void (PROFILE_APIENTRY *glDeleteQueriesPtr)(int n, const unsigned int *ids);
+void (PROFILE_APIENTRY *glQueryCounterPtr)(unsigned int id, unsigned int target);
+void (PROFILE_APIENTRY *glGetQueryObjectivPtr)(unsigned int id, unsigned int pname, int *params);
+void (PROFILE_APIENTRY *glGetQueryObjectui64vPtr)(unsigned int id, unsigned int pname, uint64_t *params);
+
+const char *PROFILE_STAGE_NAMES[PROFILE_STAGE_COUNT] = {
+    [PROFILE_INPUT] = "input",
+    [PROFILE_UPDATE_TILES] = "update tiles",
+    [PROFILE_STEPS] = "steps",
+    [PROFILE_MARK_TILES] = "mark tiles",
+    [PROFILE_DRAW_TILES] = "draw tiles",
+    [PROFILE_POST] = "post",
+    [PROFILE_FRAME] = "frame"
+};
+
+void InitProfiler(Profiler *profiler) {
+    *profiler = (Profiler) {0};
+
+#ifdef PROFILE_GPU_TIMERS
+    *(void **)&glGenQueriesPtr = rlGetProcAddress("glGenQueries");
+    *(void **)&glDeleteQueriesPtr = rlGetProcAddress("glDeleteQueries");
+    *(void **)&glQueryCounterPtr = rlGetProcAddress("glQueryCounter");
+    *(void **)&glGetQueryObjectivPtr = rlGetProcAddress("glGetQueryObjectiv");
+    *(void **)&glGetQueryObjectui64vPtr = rlGetProcAddress("glGetQueryObjectui64v");
+    profiler->has_gpu_timers = glGenQueriesPtr && glDeleteQueriesPtr && glQueryCounterPtr
+        && glGetQueryObjectivPtr && glGetQueryObjectui64vPtr;
+#endif
+
+    if (profiler->has_gpu_timers) {
+        for (int i = 0; i < PROFILE_GPU_LATENCY; i++) {
+            glGenQueriesPtr(PROFILE_MAX_GPU_SAMPLES + 1, profiler->gpu_frames[i].queries);
+        }
+    }
+}
+
+void UnloadProfiler(Profiler *profiler) {
+    StopProfileCsv(profiler);
+    if (profiler->has_gpu_timers) {
+        for (int i = 0; i < PROFILE_GPU_LATENCY; i++) {
+            glDeleteQueriesPtr(PROFILE_MAX_GPU_SAMPLES + 1, profiler->gpu_frames[i].queries);
+        }
+    }
+}
+
+void AddProfileSample(ProfileSeries *series, float ms) {
+    series->samples[series->next] = ms;
+    series->next = (series->next + 1) % PROFILE_HISTORY;
+    if (series->count < PROFILE_HISTORY) {
+        series->count++;
+    }
+}
+
+int CompareFloats(const void *a, const void *b) {
+    float x = *(const float *)a, y = *(const float *)b;
+    return (x > y) - (x < y);
+}
+
+// Nearest-rank percentile over the samples in the history, 0 when empty
+float ProfilePercentile(const ProfileSeries *series, float percentile) {
+    if (series->count == 0) {
+        return 0;
+    }
+
+    float sorted[PROFILE_HISTORY];
+    memcpy(sorted, series->samples, series->count * sizeof(float));
+    qsort(sorted, series->count, sizeof(float), CompareFloats);
+    int rank = (int)(percentile / 100 * series->count + 0.999f);
+    if (rank < 1) rank = 1;
+    return sorted[rank - 1];
+}
+
+// Beginning PROFILE_FRAME starts a new frame
+void BeginProfileStage(Profiler *profiler, ProfileStage stage) {
+    if (stage == PROFILE_FRAME) {
+        profiler->frame++;
+    }
+    profiler->stage_starts[stage] = GetTime();
+}
+
+void EndProfileStage(Profiler *profiler, ProfileStage stage) {
+    float ms = (GetTime() - profiler->stage_starts[stage]) * 1000;
+    AddProfileSample(&profiler->stages[stage], ms);
+    if (profiler->csv) {
+        fprintf(profiler->csv, "%llu,cpu,%s,%.4f\n", (unsigned long long)profiler->frame, PROFILE_STAGE_NAMES[stage], ms);
+    }
+}
+
+// Timestamps are taken when the GPU reaches them in the command stream, so
+// raylib's pending batch is flushed first to put the draws before them.
+void BeginGpuProfile(Profiler *profiler) {
+    // Flushing between passes is not free, so only while someone looks
+    if (!profiler->has_gpu_timers || !(profiler->visible || profiler->csv)) {
+        return;
+    }
+
+    GpuProfileFrame *frame = &profiler->gpu_frames[profiler->frame % PROFILE_GPU_LATENCY];
+    if (frame->pending) {
+        // Still not back after PROFILE_GPU_LATENCY frames; wait for it
+        ResolveGpuProfile(profiler, frame);
+    }
+    frame->frame = profiler->frame;
+    frame->count = 0;
+    frame->pending = true;
+    profiler->gpu_frame = frame;
+
+    rlDrawRenderBatchActive();
+    glQueryCounterPtr(frame->queries[0], GL_TIMESTAMP);
+}
+
+// Labels the GPU work since the previous mark
+void MarkGpuProfile(Profiler *profiler, const char *name) {
+    GpuProfileFrame *frame = profiler->gpu_frame;
+    if (!frame || frame->count == PROFILE_MAX_GPU_SAMPLES) {
+        return;
+    }
+
+    rlDrawRenderBatchActive();
+    frame->names[frame->count] = name;
+    glQueryCounterPtr(frame->queries[frame->count + 1], GL_TIMESTAMP);
+    frame->count++;
+}
+
+// Ends the frame's GPU samples and picks up any older frame that finished
+void EndGpuProfile(Profiler *profiler) {
+    profiler->gpu_frame = nullptr;
+    if (!profiler->has_gpu_timers) {
+        return;
+    }
+
+    for (uint64_t age = PROFILE_GPU_LATENCY - 1; age > 0; age--) {
+        if (profiler->frame < age) {
+            continue;
+        }
+        GpuProfileFrame *frame = &profiler->gpu_frames[(profiler->frame - age) % PROFILE_GPU_LATENCY];
+        if (!frame->pending || frame->count == 0) {
+            continue;
+        }
+        int available = 0;
+        glGetQueryObjectivPtr(frame->queries[frame->count], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available) {
+            ResolveGpuProfile(profiler, frame);
+        }
+    }
+}
+
+void ResolveGpuProfile(Profiler *profiler, GpuProfileFrame *frame) {
+    frame->pending = false;
+
+    // A different pass layout (another bloom mode, tier or pass count)
+    // starts the series over
+    bool same_layout = profiler->gpu_series_count == frame->count;
+    char labels[PROFILE_MAX_GPU_SAMPLES][24];
+    for (int i = 0; i < frame->count; i++) {
+        int repeat = 0;
+        for (int j = 0; j < i; j++) {
+            repeat += strcmp(frame->names[j], frame->names[i]) == 0;
+        }
+        bool repeats = repeat > 0;
+        for (int j = i + 1; j < frame->count && !repeats; j++) {
+            repeats = strcmp(frame->names[j], frame->names[i]) == 0;
+        }
+        if (repeats) {
+            snprintf(labels[i], sizeof(labels[i]), "%s %d", frame->names[i], repeat + 1);
+        } else {
+            snprintf(labels[i], sizeof(labels[i]), "%s", frame->names[i]);
+        }
+        same_layout = same_layout && strcmp(labels[i], profiler->gpu_labels[i]) == 0;
+    }
+    if (!same_layout) {
+        profiler->gpu_series_count = frame->count;
+        memcpy(profiler->gpu_labels, labels, sizeof(labels));
+        memset(profiler->gpu_series, 0, sizeof(profiler->gpu_series));
+    }
+
+    uint64_t previous;
+    glGetQueryObjectui64vPtr(frame->queries[0], GL_QUERY_RESULT, &previous);
+    for (int i = 0; i < frame->count; i++) {
+        uint64_t timestamp;
+        glGetQueryObjectui64vPtr(frame->queries[i + 1], GL_QUERY_RESULT, &timestamp);
+        float ms = (timestamp - previous) * 1e-6;
+        previous = timestamp;
+
+        AddProfileSample(&profiler->gpu_series[i], ms);
+        if (profiler->csv) {
+            fprintf(profiler->csv, "%llu,gpu,%s,%.4f\n", (unsigned long long)frame->frame, labels[i], ms);
+        }
+    }
+}
+
+bool StartProfileCsv(Profiler *profiler, const char *path) {
+    StopProfileCsv(profiler);
+    profiler->csv = fopen(path, "w");
+    if (!profiler->csv) {
+        TraceLog(LOG_WARNING, "PROFILER: Failed to open %s", path);
+        return false;
+    }
+    fprintf(profiler->csv, "frame,clock,name,ms\n");
+    TraceLog(LOG_INFO, "PROFILER: Recording to %s", path);
+    return true;
+}
+
+void StopProfileCsv(Profiler *profiler) {
+    if (profiler->csv) {
+        fclose(profiler->csv);
+        profiler->csv = nullptr;
+    }
+}
+
+void DrawProfileRow(const char *label, const ProfileSeries *series, int x, int y) {
+    DrawText(label, x, y, 10, LIGHTGRAY);
+    DrawText(TextFormat("%6.3f", ProfilePercentile(series, 50)), x + 110, y, 10, WHITE);
+    DrawText(TextFormat("%6.3f", ProfilePercentile(series, 99)), x + 160, y, 10, WHITE);
+    DrawText(TextFormat("%6.3f", ProfilePercentile(series, 100)), x + 210, y, 10, WHITE);
+}
+
+void DrawProfiler(const Profiler *profiler, int x, int y) {
+    if (!profiler->visible) {
+        return;
+    }
+
+    int rows = PROFILE_STAGE_COUNT + 3 + profiler->gpu_series_count;
+    DrawRectangle(x, y, 270, rows * 12 + 8, Fade(BLACK, 0.75));
+    x += 6;
+    y += 4;
+
+    DrawText(profiler->csv ? "ms       (recording)" : "ms", x, y, 10, YELLOW);
+    DrawText("p50", x + 110, y, 10, YELLOW);
+    DrawText("p99", x + 160, y, 10, YELLOW);
+    DrawText("max", x + 210, y, 10, YELLOW);
+    y += 12;
+
+    DrawText("CPU", x, y, 10, YELLOW);
+    y += 12;
+    for (int i = 0; i < PROFILE_STAGE_COUNT; i++) {
+        DrawProfileRow(PROFILE_STAGE_NAMES[i], &profiler->stages[i], x, y);
+        y += 12;
+    }
+
+    DrawText(profiler->has_gpu_timers ? "GPU" : "GPU timers unavailable", x, y, 10, YELLOW);
+    y += 12;
+    for (int i = 0; i < profiler->gpu_series_count; i++) {
+        DrawProfileRow(profiler->gpu_labels[i], &profiler->gpu_series[i], x, y);
+        y += 12;
+    }
+}
@@ -0,0 +1,78 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Samples kept per series for the rolling percentiles, four seconds at 60 FPS
+#define PROFILE_HISTORY 240
+// The scene, every post pass and the final draw to the screen
+#define PROFILE_MAX_GPU_SAMPLES 48
+// GPU timestamps are read back this many frames late, so the CPU never
+// waits on them
+#define PROFILE_GPU_LATENCY 4
+
+typedef enum {
+    PROFILE_INPUT,
+    PROFILE_UPDATE_TILES,
+    PROFILE_STEPS,
+    PROFILE_MARK_TILES,
+    PROFILE_DRAW_TILES,
+    PROFILE_POST,
+    PROFILE_FRAME,
+    PROFILE_STAGE_COUNT
+} ProfileStage;
+
+typedef struct {
+    float samples[PROFILE_HISTORY]; // Milliseconds, a ring buffer
+    int count;
+    int next;
+} ProfileSeries;
+
+// One frame's GPU timestamps: queries[0] is taken at BeginGpuProfile and
+// queries[i + 1] after the work labelled names[i].
+typedef struct {
+    uint64_t frame;
+    int count;
+    bool pending;
+    unsigned int queries[PROFILE_MAX_GPU_SAMPLES + 1];
+    const char *names[PROFILE_MAX_GPU_SAMPLES];
+} GpuProfileFrame;
+
+// CPU stage timings from GetTime and per-pass GPU timings from GL timestamp
+// queries. raylib does not wrap the queries, so they are loaded by hand;
+// without them (older raylib, or a driver lacking GL 3.3) only the CPU side
+// is recorded. Every sample also goes to the CSV file while one is open.
+typedef struct {
+    bool visible;
+    uint64_t frame;
+    FILE *csv;
+
+    double stage_starts[PROFILE_STAGE_COUNT];
+    ProfileSeries stages[PROFILE_STAGE_COUNT];
+
+    bool has_gpu_timers;
+    GpuProfileFrame gpu_frames[PROFILE_GPU_LATENCY];
+    GpuProfileFrame *gpu_frame; // Being recorded, nullptr outside Begin/End
+    // The series follow the sample order of the last resolved frame; labels
+    // get a number when a name repeats, as the blur passes do
+    int gpu_series_count;
+    char gpu_labels[PROFILE_MAX_GPU_SAMPLES][24];
+    ProfileSeries gpu_series[PROFILE_MAX_GPU_SAMPLES];
+} Profiler;
+
+void InitProfiler(Profiler *profiler);
+void UnloadProfiler(Profiler *profiler);
+void AddProfileSample(ProfileSeries *series, float ms);
+float ProfilePercentile(const ProfileSeries *series, float percentile);
+void BeginProfileStage(Profiler *profiler, ProfileStage stage);
+void EndProfileStage(Profiler *profiler, ProfileStage stage);
+void BeginGpuProfile(Profiler *profiler);
+void MarkGpuProfile(Profiler *profiler, const char *name);
+void EndGpuProfile(Profiler *profiler);
+void ResolveGpuProfile(Profiler *profiler, GpuProfileFrame *frame);
+bool StartProfileCsv(Profiler *profiler, const char *path);
+void StopProfileCsv(Profiler *profiler);
+void DrawProfiler(const Profiler *profiler, int x, int y);
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <stdint.h>
+
+// PCG32 (pcg-random.org): 64-bit LCG state with a permuted 32-bit output.
+// Each Random is an independent stream, so games never share RNG state.
+typedef struct {
+    uint64_t state;
+    uint64_t increment;
+} Random;
+
+static inline uint64_t SplitMix64(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+static inline uint32_t RandomNext(Random *random) {
+    uint64_t state = random->state;
+    random->state = state * 6364136223846793005ULL + random->increment;
+    uint32_t xorshifted = ((state >> 18) ^ state) >> 27;
+    uint32_t rotation = state >> 59;
+    return (xorshifted >> rotation) | (xorshifted << (-rotation & 31));
+}
+
+// Nearby seeds give unrelated streams since both the state and the stream
+// selector are derived from the seed through SplitMix64.
+static inline void SeedRandom(Random *random, uint64_t seed) {
+    random->state = 0;
+    random->increment = (SplitMix64(seed) << 1) | 1;
+    RandomNext(random);
+    random->state += SplitMix64(~seed);
+    RandomNext(random);
+}
+
+// Uniform in [0, bound), using Lemire's multiply-shift with rejection
+static inline uint32_t RandomBelow(Random *random, uint32_t bound) {
+    uint64_t product = (uint64_t)RandomNext(random) * bound;
+    uint32_t low = (uint32_t)product;
+    if (low < bound) {
+        uint32_t threshold = -bound % bound;
+        while (low < threshold) {
+            product = (uint64_t)RandomNext(random) * bound;
+            low = (uint32_t)product;
+        }
+    }
+    return product >> 32;
+}
+
+// Uniform in [min, max], like raylib's GetRandomValue
+static inline int RandomRange(Random *random, int min, int max) {
+    return min + (int)RandomBelow(random, (uint32_t)(max - min) + 1);
+}
+
+#endif
@@ -0,0 +1,201 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "replay.h"
+
+#define REPLAY_FRESH_INPUT (RIGHT_DIRECTION | RIGHT_DIRECTION << 2)
+
+// next_dir in bits 0-1, then next_next_dir and has_next_next_dir. The
+// second direction only counts while it is pending, so it packs as 0
+// otherwise and a stale value never shows up as a change.
+uint8_t PackSnakeInput(Snake *snake) {
+    uint8_t input = snake->next_dir;
+    if (snake->has_next_next_dir) {
+        input |= snake->next_next_dir << 2 | 1 << 4;
+    }
+    return input;
+}
+
+void UnpackSnakeInput(Snake *snake, uint8_t input) {
+    snake->next_dir = input & 3;
+    snake->next_next_dir = input >> 2 & 3;
+    snake->has_next_next_dir = input >> 4 & 1;
+}
+
+bool OpenReplayWriter(ReplayWriter *writer, const char *path, size_t rows, size_t columns, uint64_t seed) {
+    writer->file = fopen(path, "wb");
+    if (!writer->file) {
+        return false;
+    }
+    writer->capacity = REPLAY_BUFFER_SIZE;
+    writer->buffer = malloc(writer->capacity);
+    writer->step = 0;
+    writer->event_step = 0;
+    writer->expected = REPLAY_FRESH_INPUT;
+
+    uint8_t *header = writer->buffer;
+    memcpy(header, "SNKR", 4);
+    header[4] = REPLAY_VERSION;
+    header[5] = 0;
+    header[6] = rows;
+    header[7] = rows >> 8;
+    header[8] = columns;
+    header[9] = columns >> 8;
+    for (size_t i = 0; i < 8; i++) {
+        header[10 + i] = seed >> (8 * i);
+    }
+    writer->used = REPLAY_HEADER_SIZE;
+    return true;
+}
+
+// An event takes at most 11 bytes. A full buffer doubles rather than being
+// written out, since this runs on the frame between steps.
+void WriteReplayEvent(ReplayWriter *writer, uint8_t event) {
+    if (writer->used + 11 > writer->capacity) {
+        writer->capacity *= 2;
+        writer->buffer = realloc(writer->buffer, writer->capacity);
+    }
+
+    uint64_t delta = writer->step - writer->event_step;
+    do {
+        uint8_t byte = delta & 0x7f;
+        delta >>= 7;
+        writer->buffer[writer->used++] = byte | (delta ? 0x80 : 0);
+    } while (delta);
+    writer->buffer[writer->used++] = event;
+    writer->event_step = writer->step;
+}
+
+// Call right before every GameStep
+void RecordReplayStep(ReplayWriter *writer, Game *game) {
+    uint8_t input = PackSnakeInput(&game->player);
+    if (input != writer->expected) {
+        WriteReplayEvent(writer, input);
+    }
+
+    // What SnakeDoStep will leave: the pending direction moves up
+    Snake after = game->player;
+    if (after.has_next_next_dir) {
+        after.next_dir = after.next_next_dir;
+        after.has_next_next_dir = false;
+    }
+    writer->expected = PackSnakeInput(&after);
+    writer->step++;
+}
+
+// Call right after RestartGame
+void RecordReplayRestart(ReplayWriter *writer) {
+    WriteReplayEvent(writer, REPLAY_EVENT_RESTART);
+    writer->expected = REPLAY_FRESH_INPUT;
+}
+
+// Best done at natural pauses, like game over, so the write never lands in
+// the middle of play
+bool FlushReplayWriter(ReplayWriter *writer) {
+    bool ok = fwrite(writer->buffer, 1, writer->used, writer->file) == writer->used;
+    writer->used = 0;
+    return ok && fflush(writer->file) == 0;
+}
+
+bool CloseReplayWriter(ReplayWriter *writer) {
+    WriteReplayEvent(writer, REPLAY_EVENT_END);
+    bool ok = FlushReplayWriter(writer);
+    ok = fclose(writer->file) == 0 && ok;
+    writer->file = nullptr;
+    free(writer->buffer);
+    writer->buffer = nullptr;
+    return ok;
+}
+
+bool OpenReplayReader(ReplayReader *reader, const char *path) {
+    reader->file = fopen(path, "rb");
+    if (!reader->file) {
+        return false;
+    }
+    reader->used = 0;
+    reader->size = 0;
+
+    uint8_t header[REPLAY_HEADER_SIZE];
+    for (size_t i = 0; i < REPLAY_HEADER_SIZE; i++) {
+        if (!ReadReplayByte(reader, &header[i])) {
+            CloseReplayReader(reader);
+            return false;
+        }
+    }
+    reader->rows = header[6] | header[7] << 8;
+    reader->columns = header[8] | header[9] << 8;
+    reader->seed = 0;
+    for (size_t i = 0; i < 8; i++) {
+        reader->seed |= (uint64_t)header[10 + i] << (8 * i);
+    }
+    bool valid = memcmp(header, "SNKR", 4) == 0 && header[4] == REPLAY_VERSION
+        && reader->rows >= MIN_BOARD_SIZE && reader->rows <= MAX_BOARD_SIZE
+        && reader->columns >= MIN_BOARD_SIZE && reader->columns <= MAX_BOARD_SIZE;
+    if (!valid) {
+        CloseReplayReader(reader);
+        return false;
+    }
+
+    reader->step = 0;
+    reader->event_step = 0;
+    return ReadReplayEvent(reader);
+}
+
+bool ReadReplayByte(ReplayReader *reader, uint8_t *value) {
+    if (reader->used == reader->size) {
+        reader->size = fread(reader->buffer, 1, REPLAY_BUFFER_SIZE, reader->file);
+        reader->used = 0;
+        if (reader->size == 0) {
+            return false;
+        }
+    }
+    *value = reader->buffer[reader->used++];
+    return true;
+}
+
+// Loads the next event and the step it belongs to. A file cut short reads
+// as ending there.
+bool ReadReplayEvent(ReplayReader *reader) {
+    uint64_t delta = 0;
+    uint8_t byte;
+    for (size_t shift = 0; shift < 64; shift += 7) {
+        if (!ReadReplayByte(reader, &byte)) {
+            reader->event = REPLAY_EVENT_END;
+            reader->event_step = reader->step;
+            return false;
+        }
+        delta |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            break;
+        }
+    }
+    if (!ReadReplayByte(reader, &reader->event)) {
+        reader->event = REPLAY_EVENT_END;
+        reader->event_step = reader->step;
+        return false;
+    }
+    reader->event_step += delta;
+    return true;
+}
+
+// Applies whatever was recorded before the next step and says what to do
+ReplayAction NextReplayAction(ReplayReader *reader, Game *game) {
+    if (reader->step >= reader->event_step) {
+        uint8_t event = reader->event;
+        if (event == REPLAY_EVENT_END) {
+            return REPLAY_END;
+        }
+        ReadReplayEvent(reader);
+        if (event == REPLAY_EVENT_RESTART) {
+            return REPLAY_RESTART;
+        }
+        UnpackSnakeInput(&game->player, event);
+    }
+    reader->step++;
+    return REPLAY_STEP;
+}
+
+void CloseReplayReader(ReplayReader *reader) {
+    fclose(reader->file);
+    reader->file = nullptr;
+}
@@ -0,0 +1,75 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "game.h"
+
+// Replay files hold what a run needs to be played again: the board size,
+// the seed, and the player's buffered directions wherever they differ from
+// what the previous step left behind. Nothing else in a game depends on
+// the player, so that is enough to reproduce every step exactly.
+//
+// The header is the magic "SNKR", a version byte, a zero byte, rows and
+// columns as 16-bit and the seed as 64-bit values, all little-endian. Then
+// come events, each a LEB128 count of steps since the previous event and
+// one byte:
+//   0x00-0x1f  the direction buffer before the step (PackSnakeInput)
+//   0x40       the game was restarted before the step
+//   0x80       the end of the recording
+#define REPLAY_VERSION 1
+#define REPLAY_HEADER_SIZE 18
+#define REPLAY_EVENT_RESTART 0x40
+#define REPLAY_EVENT_END 0x80
+// The reader's buffer, and the writer's starting capacity. The writer grows
+// its buffer instead of writing when it fills, so file writes only happen at
+// FlushReplayWriter and never in the middle of play.
+#define REPLAY_BUFFER_SIZE 65536
+
+typedef struct {
+    FILE *file;
+    uint64_t step;
+    uint64_t event_step;
+    uint8_t expected; // What the buffer will hold if no input comes
+    size_t used;
+    size_t capacity;
+    uint8_t *buffer;
+} ReplayWriter;
+
+typedef enum {
+    REPLAY_STEP,    // Call GameStep
+    REPLAY_RESTART, // Call RestartGame, then ask again
+    REPLAY_END
+} ReplayAction;
+
+typedef struct {
+    FILE *file;
+    size_t rows;
+    size_t columns;
+    uint64_t seed;
+    uint64_t step;
+    uint64_t event_step;
+    uint8_t event;
+    size_t used;
+    size_t size;
+    uint8_t buffer[REPLAY_BUFFER_SIZE];
+} ReplayReader;
+
+uint8_t PackSnakeInput(Snake *snake);
+void UnpackSnakeInput(Snake *snake, uint8_t input);
+
+bool OpenReplayWriter(ReplayWriter *writer, const char *path, size_t rows, size_t columns, uint64_t seed);
+void WriteReplayEvent(ReplayWriter *writer, uint8_t event);
+void RecordReplayStep(ReplayWriter *writer, Game *game);
+void RecordReplayRestart(ReplayWriter *writer);
+bool FlushReplayWriter(ReplayWriter *writer);
+bool CloseReplayWriter(ReplayWriter *writer);
+
+bool OpenReplayReader(ReplayReader *reader, const char *path);
+bool ReadReplayByte(ReplayReader *reader, uint8_t *value);
+bool ReadReplayEvent(ReplayReader *reader);
+ReplayAction NextReplayAction(ReplayReader *reader, Game *game);
+void CloseReplayReader(ReplayReader *reader);
+
+#endif
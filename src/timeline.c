@@ -0,0 +1,573 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "replay.h"
+#include "stb_ds.h"
+#include "timeline.h"
+
+// Shorter zero runs stay inside the literals around them, where they cost
+// less than the two counts of a new run
+#define TIMELINE_MIN_ZERO_RUN 4
+
+void AppendTimelineBytes(uint8_t **bytes, const void *data, size_t size) {
+    if (size > 0) {
+        memcpy(arraddnptr(*bytes, size), data, size);
+    }
+}
+
+void AppendVarint(uint8_t **bytes, uint64_t value) {
+    do {
+        uint8_t byte = value & 0x7f;
+        value >>= 7;
+        arrput(*bytes, byte | (value ? 0x80 : 0));
+    } while (value);
+}
+
+bool ReadVarint(const uint8_t **data, const uint8_t *end, uint64_t *value) {
+    *value = 0;
+    for (size_t shift = 0; shift < 64; shift += 7) {
+        if (*data == end) {
+            return false;
+        }
+        uint8_t byte = *(*data)++;
+        *value |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// The second direction only counts while it is pending, the same as in
+// PackSnakeInput
+void PackTimelineSnake(TimelineSnake *packed, Snake *snake) {
+    memset(packed, 0, sizeof(*packed));
+    packed->head = snake->head;
+    packed->length = snake->length;
+    packed->capacity = snake->capacity;
+    packed->value = snake->value;
+    packed->dir = snake->dir;
+    packed->next_dir = snake->next_dir;
+    packed->next_next_dir = snake->has_next_next_dir ? snake->next_next_dir : 0;
+    packed->has_next_next_dir = snake->has_next_next_dir;
+}
+
+// Reads the snake's ring buffer from data, which is left past it
+void UnpackTimelineSnake(Snake *snake, TimelineSnake *packed, const uint8_t **data) {
+    snake->head = packed->head;
+    snake->length = packed->length;
+    snake->capacity = packed->capacity;
+    snake->value = packed->value;
+    snake->dir = packed->dir;
+    snake->next_dir = packed->next_dir;
+    snake->next_next_dir = packed->next_next_dir;
+    snake->has_next_next_dir = packed->has_next_next_dir;
+    snake->tiles = malloc(sizeof(Position) * snake->capacity);
+    memcpy(snake->tiles, *data, sizeof(Position) * snake->capacity);
+    *data += sizeof(Position) * snake->capacity;
+}
+
+// Snake rings are stored raw rather than from the head, so a snake that
+// moved only rewrites the slots it moved through
+void SerializeGame(Game *game, TimelineBlob *blob) {
+    size_t tiles = game->rows * game->columns;
+
+    TimelineScalars scalars;
+    memset(&scalars, 0, sizeof(scalars));
+    scalars.random = game->random;
+    scalars.free_count = game->free_count;
+    scalars.food_position = game->food.position;
+    scalars.food_value = game->food.value;
+    scalars.game_over = game->game_over;
+    scalars.board_full = game->board_full;
+    PackTimelineSnake(&scalars.player, &game->player);
+    scalars.path_start = game->player_path.start;
+    scalars.path_length = game->player_path.length;
+    scalars.clone_count = arrlen(game->clones);
+    arrsetlen(blob->bytes, sizeof(scalars));
+    memcpy(blob->bytes, &scalars, sizeof(scalars));
+    blob->sections[0] = sizeof(scalars);
+
+    size_t start = arrlen(blob->bytes);
+    AppendTimelineBytes(&blob->bytes, game->occupancy, sizeof(uint32_t) * tiles);
+    AppendTimelineBytes(&blob->bytes, game->player_occupancy, sizeof(uint32_t) * tiles);
+    AppendTimelineBytes(&blob->bytes, game->free_tiles, sizeof(uint32_t) * tiles);
+    AppendTimelineBytes(&blob->bytes, game->free_index, sizeof(uint32_t) * tiles);
+    AppendTimelineBytes(&blob->bytes, game->tileGrid.visited, sizeof(bool) * tiles);
+    blob->sections[1] = arrlen(blob->bytes) - start;
+
+    start = arrlen(blob->bytes);
+    AppendTimelineBytes(&blob->bytes, game->player.tiles, sizeof(Position) * game->player.capacity);
+    blob->sections[2] = arrlen(blob->bytes) - start;
+
+    start = arrlen(blob->bytes);
+    for (size_t i = 0; i < scalars.clone_count; i++) {
+        SnakeClone *clone = &game->clones[i];
+        TimelineSnake packed;
+        PackTimelineSnake(&packed, &clone->snake);
+        uint64_t player_path_idx = clone->player_path_idx;
+        AppendTimelineBytes(&blob->bytes, &packed, sizeof(packed));
+        AppendTimelineBytes(&blob->bytes, &player_path_idx, sizeof(player_path_idx));
+        AppendTimelineBytes(&blob->bytes, clone->snake.tiles, sizeof(Position) * clone->snake.capacity);
+    }
+    blob->sections[3] = arrlen(blob->bytes) - start;
+
+    // Only the bytes that hold steps; the rest of the last chunk is zero
+    start = arrlen(blob->bytes);
+    size_t path_bytes = (game->player_path.length - 1 + 3) / 4;
+    for (size_t offset = 0; offset < path_bytes; offset += PATH_CHUNK_STEPS / 4) {
+        size_t size = path_bytes - offset < PATH_CHUNK_STEPS / 4 ? path_bytes - offset : PATH_CHUNK_STEPS / 4;
+        AppendTimelineBytes(&blob->bytes, game->player_path.chunks[offset / (PATH_CHUNK_STEPS / 4)], size);
+    }
+    blob->sections[4] = arrlen(blob->bytes) - start;
+}
+
+// Puts the game back as it was when blob was serialized. The tile timers
+// and angles are left alone, so the animation carries on, and every tile is
+// marked dirty for its state to be recomputed.
+void RestoreGame(Game *game, TimelineBlob *blob) {
+    const uint8_t *data = blob->bytes;
+    size_t tiles = game->rows * game->columns;
+
+    TimelineScalars scalars;
+    memcpy(&scalars, data, sizeof(scalars));
+    data += sizeof(scalars);
+
+    ClearGame(game);
+    game->random = scalars.random;
+    game->free_count = scalars.free_count;
+    game->food.position = scalars.food_position;
+    game->food.value = scalars.food_value;
+    game->game_over = scalars.game_over;
+    game->board_full = scalars.board_full;
+
+    memcpy(game->occupancy, data, sizeof(uint32_t) * tiles);
+    data += sizeof(uint32_t) * tiles;
+    memcpy(game->player_occupancy, data, sizeof(uint32_t) * tiles);
+    data += sizeof(uint32_t) * tiles;
+    memcpy(game->free_tiles, data, sizeof(uint32_t) * tiles);
+    data += sizeof(uint32_t) * tiles;
+    memcpy(game->free_index, data, sizeof(uint32_t) * tiles);
+    data += sizeof(uint32_t) * tiles;
+    memcpy(game->tileGrid.visited, data, sizeof(bool) * tiles);
+    data += sizeof(bool) * tiles;
+
+    UnpackTimelineSnake(&game->player, &scalars.player, &data);
+
+    game->clones = nullptr;
+    arrsetlen(game->clones, scalars.clone_count);
+    for (size_t i = 0; i < scalars.clone_count; i++) {
+        SnakeClone *clone = &game->clones[i];
+        TimelineSnake packed;
+        uint64_t player_path_idx;
+        memcpy(&packed, data, sizeof(packed));
+        data += sizeof(packed);
+        memcpy(&player_path_idx, data, sizeof(player_path_idx));
+        data += sizeof(player_path_idx);
+        UnpackTimelineSnake(&clone->snake, &packed, &data);
+        clone->player_path_idx = player_path_idx;
+    }
+
+    InitPlayerPath(&game->player_path, scalars.path_start);
+    game->player_path.length = scalars.path_length;
+    size_t path_bytes = (scalars.path_length - 1 + 3) / 4;
+    size_t path_chunks = (scalars.path_length - 1 + PATH_CHUNK_STEPS - 1) / PATH_CHUNK_STEPS;
+    for (size_t i = 0; i < path_chunks; i++) {
+        uint8_t *chunk = calloc(PATH_CHUNK_STEPS / 4, 1);
+        size_t offset = i * (PATH_CHUNK_STEPS / 4);
+        size_t size = path_bytes - offset < PATH_CHUNK_STEPS / 4 ? path_bytes - offset : PATH_CHUNK_STEPS / 4;
+        memcpy(chunk, data, size);
+        data += size;
+        arrpush(game->player_path.chunks, chunk);
+    }
+
+    TileGrid *grid = &game->tileGrid;
+    for (uint32_t tile = 0; tile < tiles; tile++) {
+        if (!grid->dirty[tile]) {
+            grid->dirty[tile] = true;
+            grid->dirty_tiles[grid->dirty_count++] = tile;
+        }
+    }
+}
+
+uint8_t TimelineDeltaByte(const uint8_t *data, const uint8_t *previous, size_t previous_size, size_t i) {
+    return data[i] ^ (i < previous_size ? previous[i] : 0);
+}
+
+// Writes data XOR previous as runs: a zero count, a literal count, then the
+// literals, until size bytes are covered. previous is zero past its size.
+void EncodeZeroRuns(uint8_t **encoded, const uint8_t *data, size_t size, const uint8_t *previous, size_t previous_size) {
+    size_t i = 0;
+    while (i < size) {
+        size_t zeros = 0;
+        while (i < size && TimelineDeltaByte(data, previous, previous_size, i) == 0) {
+            zeros++;
+            i++;
+        }
+
+        size_t end = i;
+        size_t zero_run = 0;
+        while (end < size && zero_run < TIMELINE_MIN_ZERO_RUN) {
+            zero_run = TimelineDeltaByte(data, previous, previous_size, end) ? 0 : zero_run + 1;
+            end++;
+        }
+        if (zero_run == TIMELINE_MIN_ZERO_RUN) {
+            end -= TIMELINE_MIN_ZERO_RUN;
+        }
+
+        AppendVarint(encoded, zeros);
+        AppendVarint(encoded, end - i);
+        if (end > i) {
+            uint8_t *literals = arraddnptr(*encoded, end - i);
+            for (size_t j = i; j < end; j++) {
+                literals[j - i] = TimelineDeltaByte(data, previous, previous_size, j);
+            }
+        }
+        i = end;
+    }
+}
+
+bool DecodeZeroRuns(const uint8_t **data, const uint8_t *end, uint8_t *out, size_t size, const uint8_t *previous, size_t previous_size) {
+    size_t i = 0;
+    while (i < size) {
+        uint64_t zeros;
+        uint64_t literals;
+        if (!ReadVarint(data, end, &zeros) || !ReadVarint(data, end, &literals)) {
+            return false;
+        }
+        if (zeros + literals == 0 || zeros > size - i || literals > size - i - zeros || literals > (size_t)(end - *data)) {
+            return false;
+        }
+        memset(out + i, 0, zeros);
+        i += zeros;
+        memcpy(out + i, *data, literals);
+        *data += literals;
+        i += literals;
+    }
+
+    size_t overlap = size < previous_size ? size : previous_size;
+    for (size_t j = 0; j < overlap; j++) {
+        out[j] ^= previous[j];
+    }
+    return true;
+}
+
+// A keyframe flag byte, the section sizes, then each section's runs.
+// previous is nullptr for a keyframe.
+void EncodeSnapshot(TimelineBlob *blob, TimelineBlob *previous, uint8_t **encoded) {
+    arrsetlen(*encoded, 1);
+    (*encoded)[0] = previous == nullptr;
+    for (size_t s = 0; s < TIMELINE_SECTIONS; s++) {
+        AppendVarint(encoded, blob->sections[s]);
+    }
+
+    size_t offset = 0;
+    size_t previous_offset = 0;
+    for (size_t s = 0; s < TIMELINE_SECTIONS; s++) {
+        const uint8_t *previous_data = previous ? previous->bytes + previous_offset : nullptr;
+        size_t previous_size = previous ? previous->sections[s] : 0;
+        EncodeZeroRuns(encoded, blob->bytes + offset, blob->sections[s], previous_data, previous_size);
+        offset += blob->sections[s];
+        previous_offset += previous_size;
+    }
+}
+
+// previous is the decoded snapshot before this one, and only read when
+// this one is a delta
+bool DecodeSnapshot(const uint8_t *data, size_t size, TimelineBlob *previous, TimelineBlob *blob) {
+    const uint8_t *end = data + size;
+    if (size == 0) {
+        return false;
+    }
+    bool keyframe = *data++;
+    if (!keyframe && !previous) {
+        return false;
+    }
+
+    size_t total = 0;
+    for (size_t s = 0; s < TIMELINE_SECTIONS; s++) {
+        uint64_t section;
+        if (!ReadVarint(&data, end, &section)) {
+            return false;
+        }
+        blob->sections[s] = section;
+        total += section;
+    }
+    arrsetlen(blob->bytes, total);
+
+    size_t offset = 0;
+    size_t previous_offset = 0;
+    for (size_t s = 0; s < TIMELINE_SECTIONS; s++) {
+        const uint8_t *previous_data = keyframe ? nullptr : previous->bytes + previous_offset;
+        size_t previous_size = keyframe ? 0 : previous->sections[s];
+        if (!DecodeZeroRuns(&data, end, blob->bytes + offset, blob->sections[s], previous_data, previous_size)) {
+            return false;
+        }
+        offset += blob->sections[s];
+        previous_offset += previous_size;
+    }
+    return data == end;
+}
+
+void InitTimeline(Timeline *timeline, Game *game, size_t pool_size) {
+    *timeline = (Timeline) {
+        .pool = malloc(pool_size),
+        .pool_size = pool_size,
+        .force_keyframe = true
+    };
+    TakeTimelineSnapshot(timeline, game);
+}
+
+void FreeTimeline(Timeline *timeline) {
+    free(timeline->pool);
+    timeline->pool = nullptr;
+    arrfree(timeline->snapshots);
+    arrfree(timeline->inputs);
+    arrfree(timeline->previous.bytes);
+    arrfree(timeline->current.bytes);
+    arrfree(timeline->decoded.bytes);
+    arrfree(timeline->decoding.bytes);
+    arrfree(timeline->encoded);
+}
+
+// Returns the offset of size free bytes in the pool, dropping the oldest
+// snapshots to make room, or SIZE_MAX if that is not possible. keep_newest
+// protects the keyframe the next delta would build on.
+size_t AllocateTimelineBytes(Timeline *timeline, size_t size, bool keep_newest) {
+    if (size > timeline->pool_size) {
+        return SIZE_MAX;
+    }
+
+    for (;;) {
+        if (arrlen(timeline->snapshots) == 0) {
+            timeline->pool_head = 0;
+            timeline->pool_tail = 0;
+            timeline->wrapped = false;
+        }
+
+        size_t offset = timeline->pool_tail;
+        if (!timeline->wrapped) {
+            if (timeline->pool_size - timeline->pool_tail >= size) {
+                timeline->pool_tail += size;
+                return offset;
+            }
+            if (timeline->pool_head >= size) {
+                timeline->pool_end = timeline->pool_tail;
+                timeline->wrapped = true;
+                timeline->pool_tail = size;
+                return 0;
+            }
+        } else if (timeline->pool_head - timeline->pool_tail >= size) {
+            timeline->pool_tail += size;
+            return offset;
+        }
+
+        if (!DropOldestTimelineGroup(timeline, keep_newest)) {
+            return SIZE_MAX;
+        }
+    }
+}
+
+// Drops the oldest keyframe and the deltas built on it, and the inputs only
+// they could use
+bool DropOldestTimelineGroup(Timeline *timeline, bool keep_newest) {
+    size_t count = arrlen(timeline->snapshots);
+    if (count == 0) {
+        return false;
+    }
+    size_t end = 1;
+    while (end < count && !timeline->snapshots[end].keyframe) {
+        end++;
+    }
+    if (end == count && keep_newest) {
+        return false;
+    }
+
+    arrdeln(timeline->snapshots, 0, end);
+    uint64_t first_step = timeline->step;
+    if (end < count) {
+        TimelineSnapshot *first = &timeline->snapshots[0];
+        // Past the wrap, everything left is in one piece again
+        if (timeline->wrapped && first->offset < timeline->pool_head) {
+            timeline->wrapped = false;
+        }
+        timeline->pool_head = first->offset;
+        first_step = first->step;
+    }
+
+    TrimTimelineInputs(timeline, first_step);
+    return true;
+}
+
+// Forgets the inputs before first_step, which no seek can start from
+void TrimTimelineInputs(Timeline *timeline, uint64_t first_step) {
+    size_t dropped = first_step - timeline->input_base;
+    if (dropped > 0) {
+        arrdeln(timeline->inputs, 0, dropped);
+    }
+    timeline->input_base = first_step;
+}
+
+void TakeTimelineSnapshot(Timeline *timeline, Game *game) {
+    SerializeGame(game, &timeline->current);
+
+    bool keyframe = timeline->force_keyframe || timeline->since_keyframe >= TIMELINE_KEYFRAME_INTERVAL;
+    EncodeSnapshot(&timeline->current, keyframe ? nullptr : &timeline->previous, &timeline->encoded);
+    size_t offset = AllocateTimelineBytes(timeline, arrlen(timeline->encoded), !keyframe);
+    if (offset == SIZE_MAX && !keyframe) {
+        // The only room left is where this delta's keyframe sits
+        keyframe = true;
+        EncodeSnapshot(&timeline->current, nullptr, &timeline->encoded);
+        offset = AllocateTimelineBytes(timeline, arrlen(timeline->encoded), false);
+    }
+    if (offset == SIZE_MAX) {
+        // Bigger than the whole pool. Seeks simulate from an older snapshot
+        // instead, and the next one starts afresh.
+        timeline->force_keyframe = true;
+        if (arrlen(timeline->snapshots) == 0) {
+            TrimTimelineInputs(timeline, timeline->step);
+        }
+        return;
+    }
+
+    size_t size = arrlen(timeline->encoded);
+    memcpy(timeline->pool + offset, timeline->encoded, size);
+    TimelineSnapshot snapshot = (TimelineSnapshot) {
+        .step = timeline->step,
+        .offset = offset,
+        .size = size,
+        .keyframe = keyframe
+    };
+    arrput(timeline->snapshots, snapshot);
+    timeline->since_keyframe = keyframe ? 1 : timeline->since_keyframe + 1;
+    timeline->force_keyframe = false;
+
+    TimelineBlob swap = timeline->previous;
+    timeline->previous = timeline->current;
+    timeline->current = swap;
+}
+
+// Forgets everything after the cursor, which becomes the live end
+void TruncateTimeline(Timeline *timeline) {
+    size_t count = arrlen(timeline->snapshots);
+    while (count > 0 && timeline->snapshots[count - 1].step > timeline->cursor) {
+        count--;
+    }
+    arrsetlen(timeline->snapshots, count);
+    if (count > 0) {
+        TimelineSnapshot *last = &timeline->snapshots[count - 1];
+        if (timeline->wrapped && last->offset >= timeline->pool_head) {
+            timeline->wrapped = false;
+        }
+        timeline->pool_tail = last->offset + last->size;
+    }
+
+    arrsetlen(timeline->inputs, timeline->cursor - timeline->input_base);
+    timeline->step = timeline->cursor;
+    // previous may be one of the snapshots just dropped
+    timeline->force_keyframe = true;
+}
+
+// Call instead of GameStep. Stepping after a seek back carries on from
+// there, and the steps that were ahead are dropped.
+unsigned TimelineStep(Timeline *timeline, Game *game) {
+    if (timeline->cursor < timeline->step) {
+        TruncateTimeline(timeline);
+    }
+
+    uint8_t input = PackSnakeInput(&game->player);
+    if (timeline->pending_restart) {
+        input |= TIMELINE_INPUT_RESTART;
+        timeline->pending_restart = false;
+    }
+    arrput(timeline->inputs, input);
+
+    unsigned events = GameStep(game);
+    timeline->step++;
+    timeline->cursor = timeline->step;
+    if (timeline->step % TIMELINE_INTERVAL == 0) {
+        TakeTimelineSnapshot(timeline, game);
+    }
+    return events;
+}
+
+// Call right after RestartGame
+void TimelineRecordRestart(Timeline *timeline) {
+    timeline->pending_restart = true;
+}
+
+// The earliest step a seek can reach; the latest is timeline->step
+uint64_t TimelineFirstStep(Timeline *timeline) {
+    return arrlen(timeline->snapshots) > 0 ? timeline->snapshots[0].step : timeline->step;
+}
+
+// Puts the game at the given step, or returns false if it is out of reach.
+// Steps forward from where the game is when no snapshot is closer.
+bool TimelineSeek(Timeline *timeline, Game *game, uint64_t step) {
+    if (step == timeline->cursor) {
+        return true;
+    }
+    size_t count = arrlen(timeline->snapshots);
+    if (count == 0 || step < timeline->snapshots[0].step || step > timeline->step) {
+        return false;
+    }
+
+    // The last snapshot at or before step
+    size_t low = 0;
+    size_t high = count;
+    while (low < high) {
+        size_t middle = (low + high) / 2;
+        if (timeline->snapshots[middle].step <= step) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    size_t index = low - 1;
+
+    uint64_t from = timeline->cursor;
+    if (step < from || timeline->snapshots[index].step > from) {
+        size_t keyframe = index;
+        while (!timeline->snapshots[keyframe].keyframe) {
+            keyframe--;
+        }
+
+        TimelineBlob *blob = &timeline->decoded;
+        TimelineBlob *scratch = &timeline->decoding;
+        for (size_t i = keyframe; i <= index; i++) {
+            TimelineSnapshot *snapshot = &timeline->snapshots[i];
+            if (!DecodeSnapshot(timeline->pool + snapshot->offset, snapshot->size, i == keyframe ? nullptr : blob, scratch)) {
+                return false;
+            }
+            TimelineBlob *swap = blob;
+            blob = scratch;
+            scratch = swap;
+        }
+        RestoreGame(game, blob);
+        from = timeline->snapshots[index].step;
+    }
+
+    for (uint64_t i = from; i < step; i++) {
+        uint8_t input = timeline->inputs[i - timeline->input_base];
+        if (input & TIMELINE_INPUT_RESTART) {
+            RestartGame(game);
+        }
+        UnpackSnakeInput(&game->player, input);
+        GameStep(game);
+    }
+    timeline->cursor = step;
+    // A restart queued at the old cursor belonged to a game that is no
+    // longer on the board
+    timeline->pending_restart = false;
+    return true;
+}
+
+size_t TimelineMemoryUsed(Timeline *timeline) {
+    if (arrlen(timeline->snapshots) == 0) {
+        return 0;
+    }
+    if (timeline->wrapped) {
+        return timeline->pool_end - timeline->pool_head + timeline->pool_tail;
+    }
+    return timeline->pool_tail - timeline->pool_head;
+}
@@ -0,0 +1,125 @@
+#ifndef TIMELINE_H
+#define TIMELINE_H
+
+#include <stdint.h>
+
+#include "game.h"
+
+// Steps between snapshots, so a seek simulates at most this many steps
+#define TIMELINE_INTERVAL 64
+// Every this many snapshots one is stored whole, the rest as deltas, so a
+// seek decodes at most this many
+#define TIMELINE_KEYFRAME_INTERVAL 16
+#define TIMELINE_DEFAULT_POOL_SIZE (32 * 1024 * 1024)
+
+// Scalars, board arrays, player ring, clones, path
+#define TIMELINE_SECTIONS 5
+
+// Recorded inputs are the packed direction buffer (PackSnakeInput), with
+// this bit set when the game was restarted before the step
+#define TIMELINE_INPUT_RESTART 0x40
+
+// Snakes and the scalars are copied through these rather than as they sit
+// in Game, so padding is always zero and snapshots compare byte for byte
+typedef struct {
+    uint64_t head;
+    uint64_t length;
+    uint64_t capacity;
+    uint8_t value;
+    uint8_t dir;
+    uint8_t next_dir;
+    uint8_t next_next_dir;
+    uint8_t has_next_next_dir;
+} TimelineSnake;
+
+typedef struct {
+    Random random;
+    uint64_t free_count;
+    Position food_position;
+    uint32_t food_value;
+    uint8_t game_over;
+    uint8_t board_full;
+    TimelineSnake player;
+    Position path_start;
+    uint64_t path_length;
+    uint64_t clone_count;
+} TimelineScalars;
+
+// A game serialized in sections. bytes is an stb array reused between
+// snapshots.
+typedef struct {
+    uint8_t *bytes;
+    size_t sections[TIMELINE_SECTIONS];
+} TimelineBlob;
+
+// Where a snapshot sits in the pool
+typedef struct {
+    uint64_t step;
+    size_t offset;
+    size_t size;
+    bool keyframe;
+} TimelineSnapshot;
+
+// Every step's input plus a snapshot of the whole game every
+// TIMELINE_INTERVAL steps. Seeking restores the nearest snapshot at or
+// before the target and simulates forward from there, so it costs the same
+// anywhere in a run.
+//
+// Snapshots are XORed against the previous one section by section, which
+// leaves zeros wherever nothing changed, and those zero runs are then
+// squeezed out. They live in a fixed size ring pool: when it fills up, the
+// oldest keyframe and its deltas are dropped, along with their inputs.
+typedef struct {
+    uint8_t *pool;
+    size_t pool_size;
+    size_t pool_head; // Offset of the oldest snapshot
+    size_t pool_tail; // Where the next snapshot goes
+    size_t pool_end;  // End of the data before the wrap, while wrapped
+    bool wrapped;
+    TimelineSnapshot *snapshots;
+
+    uint8_t *inputs;     // inputs[i] goes with step input_base + i
+    uint64_t input_base; // The oldest snapshot's step
+    uint64_t step;       // Steps recorded, the live end of the timeline
+    uint64_t cursor;     // The step the game is at, behind step after a seek
+    bool pending_restart;
+    bool force_keyframe;
+    size_t since_keyframe;
+
+    TimelineBlob previous; // The newest snapshot, for the next delta
+    TimelineBlob current;
+    TimelineBlob decoded;  // Seek scratch, so previous survives a seek
+    TimelineBlob decoding;
+    uint8_t *encoded;
+} Timeline;
+
+void InitTimeline(Timeline *timeline, Game *game, size_t pool_size);
+void FreeTimeline(Timeline *timeline);
+
+void AppendTimelineBytes(uint8_t **bytes, const void *data, size_t size);
+void AppendVarint(uint8_t **bytes, uint64_t value);
+bool ReadVarint(const uint8_t **data, const uint8_t *end, uint64_t *value);
+void PackTimelineSnake(TimelineSnake *packed, Snake *snake);
+void UnpackTimelineSnake(Snake *snake, TimelineSnake *packed, const uint8_t **data);
+
+void SerializeGame(Game *game, TimelineBlob *blob);
+void RestoreGame(Game *game, TimelineBlob *blob);
+uint8_t TimelineDeltaByte(const uint8_t *data, const uint8_t *previous, size_t previous_size, size_t i);
+void EncodeZeroRuns(uint8_t **encoded, const uint8_t *data, size_t size, const uint8_t *previous, size_t previous_size);
+bool DecodeZeroRuns(const uint8_t **data, const uint8_t *end, uint8_t *out, size_t size, const uint8_t *previous, size_t previous_size);
+void EncodeSnapshot(TimelineBlob *blob, TimelineBlob *previous, uint8_t **encoded);
+bool DecodeSnapshot(const uint8_t *data, size_t size, TimelineBlob *previous, TimelineBlob *blob);
+
+size_t AllocateTimelineBytes(Timeline *timeline, size_t size, bool keep_newest);
+bool DropOldestTimelineGroup(Timeline *timeline, bool keep_newest);
+void TrimTimelineInputs(Timeline *timeline, uint64_t first_step);
+void TakeTimelineSnapshot(Timeline *timeline, Game *game);
+void TruncateTimeline(Timeline *timeline);
+
+unsigned TimelineStep(Timeline *timeline, Game *game);
+void TimelineRecordRestart(Timeline *timeline);
+uint64_t TimelineFirstStep(Timeline *timeline);
+bool TimelineSeek(Timeline *timeline, Game *game, uint64_t step);
+size_t TimelineMemoryUsed(Timeline *timeline);
+
+#endif